@@ -13,38 +13,66 @@ PKGCONFIG += mpv
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    blurhash.cpp \
+    catalogquery.cpp \
     filedetailstab.cpp \
     filehasher.cpp \
+    fileidentity.cpp \
     filterproxy.cpp \
+    foldedsearch.cpp \
     imageview.cpp \
     main.cpp \
     mainwindow.cpp \
     mpvopenglwidget.cpp \
-    pagedproxy.cpp \
     paginationbar.cpp \
     picturedetailstab.cpp \
+    querymatcher.cpp \
+    rowbitmap.cpp \
+    searchindex.cpp \
+    sidecarimporter.cpp \
+    storeconnection.cpp \
+    storewriter.cpp \
+    tagcompleter.cpp \
+    tagdictionary.cpp \
+    tageditorbinding.cpp \
     taggerstore.cpp \
     thumbnaildelegate.cpp \
     thumbnailmanager.cpp \
     thumbnailmodel.cpp \
+    thumbnailprefetcher.cpp \
+    trigramindex.cpp \
     videodetailstab.cpp \
     workspacelistmodel.cpp
 
 HEADERS += \
+    blurhash.h \
+    catalogquery.h \
     filedetailstab.h \
     filehasher.h \
+    fileidentity.h \
     fileitem.h \
     filterproxy.h \
+    foldedsearch.h \
     imageview.h \
     mainwindow.h \
     mpvopenglwidget.h \
-    pagedproxy.h \
     paginationbar.h \
     picturedetailstab.h \
+    querymatcher.h \
+    rowbitmap.h \
+    searchindex.h \
+    sidecarimporter.h \
+    storeconnection.h \
+    storewriter.h \
+    tagcompleter.h \
+    tagdictionary.h \
+    tageditorbinding.h \
     taggerstore.h \
     thumbnaildelegate.h \
     thumbnailmanager.h \
     thumbnailmodel.h \
+    thumbnailprefetcher.h \
+    trigramindex.h \
     videodetailstab.h \
     workspacelistmodel.h
 
@@ -0,0 +1,206 @@
+#include "blurhash.h"
+
+#include <QVector>
+#include <QtMath>
+#include <cmath>
+#include <cstring>
+
+namespace BlurHash {
+
+static const char kBase83[] =
+    "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz#$%*+,-.:;=?@[]^_{|}~";
+
+// Encoding works on a tiny copy; the hash can't carry more detail than this anyway.
+static const int kSampleSize = 32;
+
+static void appendBase83(QString& out, int value, int length) {
+    for (int i = 1; i <= length; ++i) {
+        int divisor = 1;
+        for (int k = 0; k < length - i; ++k) divisor *= 83;
+        out += QLatin1Char(kBase83[(value / divisor) % 83]);
+    }
+}
+
+static bool decodeBase83(const QString& s, int from, int length, int* out) {
+    int value = 0;
+    for (int i = from; i < from + length; ++i) {
+        const char c = s[i].toLatin1();
+        const char* p = c ? std::strchr(kBase83, c) : nullptr;
+        if (!p) return false;
+        value = value * 83 + int(p - kBase83);
+    }
+    *out = value;
+    return true;
+}
+
+static double srgbToLinear(int v) {
+    const double x = v / 255.0;
+    return x <= 0.04045 ? x / 12.92 : std::pow((x + 0.055) / 1.055, 2.4);
+}
+
+static int linearToSrgb(double v) {
+    const double x = qBound(0.0, v, 1.0);
+    if (x <= 0.0031308) return int(x * 12.92 * 255 + 0.5);
+    return int((1.055 * std::pow(x, 1 / 2.4) - 0.055) * 255 + 0.5);
+}
+
+static double signPow(double v, double exp) {
+    return std::copysign(std::pow(std::fabs(v), exp), v);
+}
+
+struct Linear { double r = 0, g = 0, b = 0; };
+
+QString encode(const QImage& image, int componentsX, int componentsY) {
+    if (image.isNull()) return {};
+    if (componentsX < 1 || componentsX > 9 || componentsY < 1 || componentsY > 9) return {};
+
+    const QImage img = image.scaled(kSampleSize, kSampleSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+                           .convertToFormat(QImage::Format_RGB32);
+    const int w = img.width();
+    const int h = img.height();
+
+    // Linearise once; the basis loop below touches every pixel per component.
+    QVector<Linear> px(w * h);
+    for (int y = 0; y < h; ++y) {
+        const QRgb* line = reinterpret_cast<const QRgb*>(img.constScanLine(y));
+        for (int x = 0; x < w; ++x) {
+            Linear& l = px[y * w + x];
+            l.r = srgbToLinear(qRed(line[x]));
+            l.g = srgbToLinear(qGreen(line[x]));
+            l.b = srgbToLinear(qBlue(line[x]));
+        }
+    }
+
+    QVector<Linear> factors(componentsX * componentsY);
+    for (int j = 0; j < componentsY; ++j) {
+        for (int i = 0; i < componentsX; ++i) {
+            const double norm = (i == 0 && j == 0) ? 1.0 : 2.0;
+            Linear f;
+            for (int y = 0; y < h; ++y) {
+                const double by = std::cos(M_PI * j * y / h);
+                for (int x = 0; x < w; ++x) {
+                    const double basis = norm * std::cos(M_PI * i * x / w) * by;
+                    const Linear& l = px[y * w + x];
+                    f.r += basis * l.r;
+                    f.g += basis * l.g;
+                    f.b += basis * l.b;
+                }
+            }
+            const double scale = 1.0 / (w * h);
+            f.r *= scale; f.g *= scale; f.b *= scale;
+            factors[j * componentsX + i] = f;
+        }
+    }
+
+    QString out;
+    out.reserve(4 + 2 * componentsX * componentsY);
+    appendBase83(out, (componentsX - 1) + (componentsY - 1) * 9, 1);
+
+    double maxValue = 1.0;
+    if (factors.size() > 1) {
+        double actual = 0;
+        for (int k = 1; k < factors.size(); ++k) {
+            actual = qMax(actual, std::fabs(factors[k].r));
+            actual = qMax(actual, std::fabs(factors[k].g));
+            actual = qMax(actual, std::fabs(factors[k].b));
+        }
+        const int quantised = qBound(0, int(std::floor(actual * 166 - 0.5)), 82);
+        maxValue = (quantised + 1) / 166.0;
+        appendBase83(out, quantised, 1);
+    } else {
+        appendBase83(out, 0, 1);
+    }
+
+    const Linear& dc = factors[0];
+    appendBase83(out, (linearToSrgb(dc.r) << 16) + (linearToSrgb(dc.g) << 8) + linearToSrgb(dc.b), 4);
+
+    auto quantAc = [maxValue](double v) {
+        return qBound(0, int(std::floor(signPow(v / maxValue, 0.5) * 9 + 9.5)), 18);
+    };
+    for (int k = 1; k < factors.size(); ++k) {
+        const Linear& f = factors[k];
+        appendBase83(out, quantAc(f.r) * 19 * 19 + quantAc(f.g) * 19 + quantAc(f.b), 2);
+    }
+    return out;
+}
+
+QImage decode(const QString& hash, int width, int height, double punch) {
+    if (hash.size() < 6 || width <= 0 || height <= 0) return {};
+
+    int sizeFlag = 0;
+    if (!decodeBase83(hash, 0, 1, &sizeFlag)) return {};
+    const int numY = sizeFlag / 9 + 1;
+    const int numX = sizeFlag % 9 + 1;
+    if (hash.size() != 4 + 2 * numX * numY) return {};
+
+    int quantMax = 0;
+    if (!decodeBase83(hash, 1, 1, &quantMax)) return {};
+    const double maxValue = (quantMax + 1) / 166.0 * punch;
+
+    QVector<Linear> colors(numX * numY);
+    int dc = 0;
+    if (!decodeBase83(hash, 2, 4, &dc)) return {};
+    colors[0].r = srgbToLinear((dc >> 16) & 0xff);
+    colors[0].g = srgbToLinear((dc >> 8) & 0xff);
+    colors[0].b = srgbToLinear(dc & 0xff);
+
+    for (int k = 1; k < colors.size(); ++k) {
+        int ac = 0;
+        if (!decodeBase83(hash, 4 + k * 2, 2, &ac)) return {};
+        colors[k].r = signPow((ac / (19 * 19) - 9) / 9.0, 2.0) * maxValue;
+        colors[k].g = signPow((ac / 19 % 19 - 9) / 9.0, 2.0) * maxValue;
+        colors[k].b = signPow((ac % 19 - 9) / 9.0, 2.0) * maxValue;
+    }
+
+    QImage img(width, height, QImage::Format_RGB32);
+    for (int y = 0; y < height; ++y) {
+        QRgb* line = reinterpret_cast<QRgb*>(img.scanLine(y));
+        for (int x = 0; x < width; ++x) {
+            Linear c;
+            for (int j = 0; j < numY; ++j) {
+                const double by = std::cos(M_PI * y * j / height);
+                for (int i = 0; i < numX; ++i) {
+                    const double basis = std::cos(M_PI * x * i / width) * by;
+                    const Linear& f = colors[j * numX + i];
+                    c.r += f.r * basis;
+                    c.g += f.g * basis;
+                    c.b += f.b * basis;
+                }
+            }
+            line[x] = qRgb(linearToSrgb(c.r), linearToSrgb(c.g), linearToSrgb(c.b));
+        }
+    }
+    return img;
+}
+
+QRgb dominantColor(const QImage& image) {
+    if (image.isNull()) return 0;
+
+    const QImage img = image.scaled(kSampleSize, kSampleSize, Qt::IgnoreAspectRatio, Qt::FastTransformation)
+                           .convertToFormat(QImage::Format_RGB32);
+
+    // 4 bits per channel is coarse enough that noise and gradients fall into one bucket.
+    struct Bucket { int count = 0; qint64 r = 0, g = 0, b = 0; };
+    QVector<Bucket> buckets(16 * 16 * 16);
+    int best = 0;
+
+    for (int y = 0; y < img.height(); ++y) {
+        const QRgb* line = reinterpret_cast<const QRgb*>(img.constScanLine(y));
+        for (int x = 0; x < img.width(); ++x) {
+            const QRgb c = line[x];
+            const int key = ((qRed(c) >> 4) << 8) | ((qGreen(c) >> 4) << 4) | (qBlue(c) >> 4);
+            Bucket& b = buckets[key];
+            ++b.count;
+            b.r += qRed(c);
+            b.g += qGreen(c);
+            b.b += qBlue(c);
+            if (b.count > buckets[best].count) best = key;
+        }
+    }
+
+    const Bucket& b = buckets[best];
+    if (b.count == 0) return 0;
+    return qRgb(int(b.r / b.count), int(b.g / b.count), int(b.b / b.count));
+}
+
+} // namespace BlurHash
@@ -0,0 +1,22 @@
+#ifndef BLURHASH_H
+#define BLURHASH_H
+
+#pragma once
+#include <QImage>
+#include <QString>
+
+// Compact BlurHash (https://blurha.sh) encoder/decoder used for tile placeholders.
+namespace BlurHash {
+
+// componentsX/Y must be in 1..9. 4x3 gives a 28 character hash.
+QString encode(const QImage& image, int componentsX = 4, int componentsY = 3);
+
+// Returns a null image if the hash is malformed.
+QImage decode(const QString& hash, int width, int height, double punch = 1.0);
+
+// Most populous colour of the image (coarse histogram, averaged within the winning bucket).
+QRgb dominantColor(const QImage& image);
+
+} // namespace BlurHash
+
+#endif // BLURHASH_H
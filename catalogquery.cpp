@@ -0,0 +1,96 @@
+#include "catalogquery.h"
+
+#include "foldedsearch.h"
+
+namespace CatalogQuery {
+
+using namespace QueryMatcher;
+
+static const char* sqlCmp(CmpOp op) {
+    switch (op) {
+    case CmpOp::Lt: return "<";
+    case CmpOp::Le: return "<=";
+    case CmpOp::Gt: return ">";
+    case CmpOp::Ge: return ">=";
+    case CmpOp::Eq: return "=";
+    }
+    return "=";
+}
+
+// FTS5 query string matching the needle as one literal phrase
+static QString ftsPhrase(const QString& needle) {
+    QString escaped = needle;
+    escaped.replace('"', QStringLiteral("\"\""));
+    return '"' + escaped + '"';
+}
+
+static void compileTerm(const Term& t, bool fts, Where* out) {
+    switch (t.kind) {
+    case TermKind::Never:
+        out->sql += "0";
+        return;
+    case TermKind::Picture:
+    case TermKind::Video:
+        out->sql += "c.kind = ?";
+        out->binds << int(t.kind == TermKind::Picture ? FileKind::Picture : FileKind::Video);
+        return;
+    case TermKind::Year:
+    case TermKind::Size:
+        out->sql += QString("c.%1 %2 ?").arg(t.kind == TermKind::Year ? "year" : "size", sqlCmp(t.cmp));
+        out->binds << t.value;
+        return;
+    case TermKind::Text:
+        break;
+    }
+
+    if (t.folded.isEmpty()) {
+        out->sql += "1";
+        return;
+    }
+
+    // The trigram tokenizer needs three characters to look anything up
+    out->sql += "(";
+    if (fts && t.folded.toUcs4().size() >= 3) {
+        out->sql += "c.id IN (SELECT rowid FROM catalog_fts WHERE catalog_fts MATCH ?) AND ";
+        out->binds << ftsPhrase(t.folded);
+    }
+    out->sql += "(instr(c.name_folded, ?) > 0 OR instr(c.tags_folded, ?) > 0))";
+    out->binds << t.folded << QString('\n' + t.folded + '\n');
+}
+
+static void compileNode(const Plan& plan, int node, bool fts, Where* out) {
+    const Node& n = plan.nodes()[node];
+    if (n.op == OpCode::Term) {
+        compileTerm(plan.terms()[n.term], fts, out);
+        return;
+    }
+    out->sql += "(";
+    for (int i = 0; i < n.children.size(); ++i) {
+        if (i) out->sql += n.op == OpCode::And ? " AND " : " OR ";
+        compileNode(plan, n.children[i], fts, out);
+    }
+    out->sql += ")";
+}
+
+Where compile(const Plan& plan, bool fts) {
+    Where out;
+    if (plan.isEmpty() || plan.nodes().isEmpty()) {
+        out.sql = "0";
+        return out;
+    }
+    compileNode(plan, plan.nodes().size() - 1, fts, &out);
+    return out;
+}
+
+QString foldedTagLines(const QStringList& tags) {
+    QString out(QLatin1Char('\n'));
+    for (const QString& t : tags) {
+        const QString folded = FoldedSearch::fold(t.trimmed());
+        if (folded.isEmpty()) continue;
+        out += folded;
+        out += QLatin1Char('\n');
+    }
+    return out;
+}
+
+} // namespace CatalogQuery
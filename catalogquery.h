@@ -0,0 +1,33 @@
+#ifndef CATALOGQUERY_H
+#define CATALOGQUERY_H
+
+#pragma once
+#include <QString>
+#include <QVariantList>
+#include "querymatcher.h"
+
+// Search box queries pushed down to SQL over TaggerStore's catalog table, with
+// the same results the in-memory filter gives for the same rows:
+//   picture, video      catalog.kind
+//   year/size compares  catalog.year / catalog.size (indexed)
+//   text                folded name contains it, or a folded tag equals it.
+//                       Needles of 3+ characters first narrow the rows through
+//                       the trigram FTS5 index (catalog_fts), then confirm;
+//                       without that index (old SQLite), confirm on every row.
+namespace CatalogQuery {
+
+struct Where {
+    QString sql;        // boolean expression over alias c (catalog)
+    QVariantList binds; // positional, in order
+};
+
+// Empty plan: "0" (matches nothing). fts: the database has catalog_fts.
+Where compile(const QueryMatcher::Plan& plan, bool fts = true);
+
+// Column layout of catalog.tags_folded: each folded tag on its own line, with a
+// leading and a trailing newline, so "tag equals x" is a substring test.
+QString foldedTagLines(const QStringList& tags);
+
+} // namespace CatalogQuery
+
+#endif // CATALOGQUERY_H
@@ -8,6 +8,7 @@
 #include <QCryptographicHash>
 #include <QDateTime>
 #include <QMetaObject>
+#include <QThread>
 
 static QString md5File(const QString& path) {
     QFile f(path);
@@ -26,12 +27,26 @@ static QString md5File(const QString& path) {
     return QString::fromLatin1(h.result().toHex());
 }
 
+// Cached hash if the file is unchanged, else md5 (and cache it); empty on failure
+static QString hashOf(TaggerStore* store, const QString& path) {
+    const QFileInfo fi(path);
+    if (!fi.exists() || !fi.isFile()) return {};
+    const qint64 size = fi.size();
+    const qint64 mtime = fi.lastModified().toSecsSinceEpoch();
+
+    if (auto cached = store->getCachedHashIfValid(path, size, mtime)) return *cached;
+    const QString hash = md5File(path);
+    if (!hash.isEmpty()) store->upsertHashCache(path, size, mtime, hash); // queued, thread-safe
+    return hash;
+}
+
 FileHasher::FileHasher(TaggerStore* store, QObject* parent)
     : QObject(parent), m_store(store) {
     m_pool.setMaxThreadCount(qMax(2, QThread::idealThreadCount() - 1));
 }
 
 FileHasher::~FileHasher() {
+    m_stopping = true;
     m_pool.clear();
     m_pool.waitForDone();
 }
@@ -39,50 +54,74 @@ FileHasher::~FileHasher() {
 void FileHasher::request(const QString& path) {
     if (!m_store || path.isEmpty()) return;
 
-    // Capture file info now (cheap) so worker can validate cache.
-    const QFileInfo fi(path);
-    if (!fi.exists() || !fi.isFile()) return;
-
-    const qint64 size = fi.size();
-    const qint64 mtime = fi.lastModified().toSecsSinceEpoch();
-
-    // Fast path: cache hit
-    if (auto cached = m_store->getCachedHashIfValid(path, size, mtime)) {
-        emit hashReady(path, *cached);
-        return;
-    }
-
-    // Async job
+    // Everything, cache lookup included, runs on the pool: stat and SQL can both
+    // stall on a slow disk
     struct Job : public QRunnable {
         QPointer<FileHasher> self;
+        TaggerStore* store;
         QString path;
-        qint64 size;
-        qint64 mtime;
-
-        Job(QPointer<FileHasher> hasher, const QString &filePath, qint64 fileSize, qint64 fileMtime) {
-            self = hasher;
-            path = filePath;
-            size = fileSize;
-            mtime = fileMtime;
-        }
+
+        Job(QPointer<FileHasher> hasher, TaggerStore* s, const QString& filePath)
+            : self(hasher), store(s), path(filePath) {}
 
         void run() override {
             if (!self) return;
-
-            const QString hash = md5File(path);
+            const QString hash = hashOf(store, path);
             if (hash.isEmpty() || !self) return;
 
-            // Store cache + emit on GUI thread
-            QMetaObject::invokeMethod(self, [s=self, path=path, hash=hash, size=size, mtime=mtime]{
-                if (!s || !s->m_store) return;
-                s->m_store->upsertHashCache(path, size, mtime, hash);
-                emit s->hashReady(path, hash);
+            // Emit on GUI thread
+            QMetaObject::invokeMethod(self, [s=self, path=path, hash=hash]{
+                if (s) emit s->hashReady(path, hash);
             }, Qt::QueuedConnection);
         }
     };
 
-    auto* job = new Job{QPointer<FileHasher>(this), path, size, mtime};
+    auto* job = new Job(QPointer<FileHasher>(this), m_store, path);
     job->setAutoDelete(true);
     m_pool.start(job);
 }
 
+void FileHasher::requestBatch(const QStringList& paths) {
+    if (!m_store || paths.isEmpty()) return;
+
+    struct Job : public QRunnable {
+        QPointer<FileHasher> self;
+        TaggerStore* store;
+        QStringList paths;
+        const std::atomic<bool>* stopping;
+
+        Job(QPointer<FileHasher> hasher, TaggerStore* s, const QStringList& p, const std::atomic<bool>* stop)
+            : self(hasher), store(s), paths(p), stopping(stop) {}
+
+        void post(QVector<QPair<QString, QString>>* done) {
+            if (done->isEmpty()) return;
+            QMetaObject::invokeMethod(self, [s = self, results = std::move(*done)] {
+                if (s) emit s->batchHashed(results);
+            }, Qt::QueuedConnection);
+            done->clear();
+        }
+
+        void run() override {
+            // Bulk tagging can queue thousands of files: let the UI and single
+            // requests have the CPU and disk first
+            QThread* thread = QThread::currentThread();
+            const QThread::Priority priority = thread->priority();
+            thread->setPriority(QThread::LowPriority);
+
+            QVector<QPair<QString, QString>> done;
+            for (const QString& path : paths) {
+                if (*stopping || !self) break;
+                const QString hash = hashOf(store, path);
+                if (!hash.isEmpty()) done.push_back({path, hash});
+                if (done.size() == kBatchChunk) post(&done);
+            }
+            if (!*stopping) post(&done);
+
+            thread->setPriority(priority);
+        }
+    };
+
+    auto* job = new Job(QPointer<FileHasher>(this), m_store, paths, &m_stopping);
+    job->setAutoDelete(true);
+    m_pool.start(job, -1); // behind request()s already queued
+}
@@ -5,6 +5,9 @@
 #include <QObject>
 #include <QThreadPool>
 #include <QPointer>
+#include <QStringList>
+#include <QVector>
+#include <atomic>
 
 class TaggerStore;
 
@@ -17,12 +20,20 @@ public:
     // Request hash; result comes via hashReady
     void request(const QString& path);
 
+    // Many files as one job behind any request(), on a low-priority thread.
+    // Results come via batchHashed, kBatchChunk at a time; no hashReady.
+    void requestBatch(const QStringList& paths);
+
+    static constexpr int kBatchChunk = 256;
+
 signals:
     void hashReady(const QString& path, const QString& hash);
+    void batchHashed(const QVector<QPair<QString, QString>>& pathHashes);
 
 private:
-    TaggerStore* m_store = nullptr; // owned by MainWindow
+    TaggerStore* m_store = nullptr; // owned by MainWindow, must outlive this (jobs use it)
     QThreadPool m_pool;
+    std::atomic<bool> m_stopping{false}; // set on destruction: a running batch stops
 };
 
 
@@ -0,0 +1,72 @@
+#include "fileidentity.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <cstring>
+#endif
+
+FileIdentity FileIdentity::of(const QString& path) {
+    FileIdentity id;
+#ifdef Q_OS_WIN
+    // Backup semantics lets this open directories too; no access rights needed
+    HANDLE h = CreateFileW(reinterpret_cast<LPCWSTR>(path.utf16()), 0,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                           OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return id;
+    BY_HANDLE_FILE_INFORMATION info;
+    if (GetFileInformationByHandle(h, &info)) {
+        id.device = info.dwVolumeSerialNumber;
+        id.inode = (quint64(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+    }
+    CloseHandle(h);
+#else
+    struct stat st;
+    if (::stat(QFile::encodeName(path).constData(), &st) == 0) {
+        id.device = quint64(st.st_dev);
+        id.inode = quint64(st.st_ino);
+    }
+#endif
+    return id;
+}
+
+#ifndef Q_OS_WIN
+static bool isDirEntry(const QByteArray& dir, const dirent* e) {
+#ifdef DT_DIR
+    if (e->d_type != DT_UNKNOWN) return e->d_type == DT_DIR;
+#endif
+    struct stat st; // some file systems leave the type out
+    return ::lstat((dir + '/' + e->d_name).constData(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+#endif
+
+QVector<FileIdentity::Entry> FileIdentity::list(const QString& dir) {
+    QVector<Entry> out;
+#ifdef Q_OS_WIN
+    // No inode numbers in a directory listing here: one open per entry
+    const QFileInfoList infos = QDir(dir).entryInfoList(QDir::AllEntries | QDir::Hidden | QDir::System
+                                                        | QDir::NoDotAndDotDot);
+    for (const QFileInfo& fi : infos) {
+        out.push_back({fi.fileName(), of(fi.absoluteFilePath()), fi.isDir() && !fi.isSymLink()});
+    }
+#else
+    const QByteArray path = QFile::encodeName(dir);
+    struct stat st;
+    if (::stat(path.constData(), &st) != 0) return out;
+    DIR* d = ::opendir(path.constData());
+    if (!d) return out;
+    while (const dirent* e = ::readdir(d)) {
+        if (std::strcmp(e->d_name, ".") == 0 || std::strcmp(e->d_name, "..") == 0) continue;
+        out.push_back({QFile::decodeName(e->d_name), {quint64(st.st_dev), quint64(e->d_ino)},
+                       isDirEntry(path, e)});
+    }
+    ::closedir(d);
+#endif
+    return out;
+}
@@ -0,0 +1,36 @@
+#ifndef FILEIDENTITY_H
+#define FILEIDENTITY_H
+
+#pragma once
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+// What a file is rather than where it is: (st_dev, st_ino) on POSIX, (volume
+// serial, file index) on Windows. Survives renames and moves within a volume,
+// so the store can follow files to their new paths without rehashing them.
+// Inode numbers get reused after a delete; pair with size and mtime before
+// trusting a match.
+struct FileIdentity {
+    quint64 device = 0;
+    quint64 inode = 0;
+
+    bool isValid() const { return device || inode; }
+    bool operator==(const FileIdentity& o) const { return device == o.device && inode == o.inode; }
+    bool operator!=(const FileIdentity& o) const { return !(*this == o); }
+
+    // Invalid if the file cannot be stat()ed (or opened, on Windows)
+    static FileIdentity of(const QString& path);
+
+    struct Entry {
+        QString name;
+        FileIdentity id;
+        bool isDir = false; // symlinks are not followed
+    };
+    // The entries of dir but . and .., each with its identity. On POSIX the inode
+    // comes from readdir() and the device from dir: one stat() for the folder, not
+    // one per entry. A volume mounted on an entry shows as what is underneath.
+    static QVector<Entry> list(const QString& dir);
+};
+
+#endif // FILEIDENTITY_H
@@ -5,6 +5,7 @@
 #include <QDateTime>
 #include <QFileInfo>
 #include <QIcon>
+#include <QRgb>
 #include <QImageReader>
 #include <QSet>
 #include <QString>
@@ -38,12 +39,21 @@ inline FileKind classifyFileKind(const QFileInfo& fi) {
     return FileKind::GenericFile;
 }
 
+// Cheap stand-in painted until the real thumbnail arrives.
+struct ThumbPlaceholder {
+    QRgb color = 0;    // dominant colour; 0 (fully transparent) means unknown
+    QString blurHash;  // ~28 chars, see blurhash.h
+
+    bool isNull() const { return color == 0 && blurHash.isEmpty(); }
+};
+
 struct FileItem {
     QString absolutePath;
     QString fileName;
     QIcon icon;       // always: real file icon (details tab)
     QIcon thumbIcon;  // only: used in main grid when ready
     ThumbStatus thumbStatus = ThumbStatus::NotRequested;
+    ThumbPlaceholder placeholder;
     FileKind kind = FileKind::GenericFile;
     QDateTime modified;
     QDateTime created;
@@ -3,329 +3,467 @@
 #include "thumbnailmodel.h"
 
 #include <QString>
-#include <QStringList>
-#include <QDateTime>
-#include <QVector>
-#include <QStack>
-#include <functional>
-
-
-namespace QueryMatcher {
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QRunnable>
+#include <QThread>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+// Enable with QT_LOGGING_RULES="tagger.filter.debug=true" to get per-keystroke filter timings.
+Q_LOGGING_CATEGORY(lcFilter, "tagger.filter", QtWarningMsg)
+
+// Rows per worker slice: a multiple of RowBitmap's 64K chunk so slices never share a chunk
+static const int kSliceRows = 1 << 16;
+
+// Scroll mode: rows handed to the view per fetchMore()
+static const int kFetchBatch = 512;
+
+// One evaluation of one needle, shared by its slice jobs
+struct FilterProxy::Run {
+    QString needle;
+    QueryMatcher::Plan plan;
+    QueryMatcher::Binding binding;
+    SearchIndex index;       // implicitly shared snapshot
+    RowBitmap domain;        // refinement candidates ...
+    bool restricted = false; // ... if set
+    QElapsedTimer timer;
+    std::shared_ptr<QueryMatcher::Selectivity> stats;
+
+    std::atomic<bool> cancelled{false};
+    std::atomic<int> remaining{0};
+    std::vector<RowBitmap> slices; // each written by exactly one job
+};
 
-// ---------- Lexing ----------
+FilterProxy::FilterProxy(QObject* parent) : QAbstractProxyModel(parent) {
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
 
-enum class LexKind { Word, Number, CmpOp, AndOp, OrOp };
+    // Coalesce bursts of keystrokes; cancellation covers the rest
+    m_debounce.setSingleShot(true);
+    m_debounce.setInterval(40);
+    connect(&m_debounce, &QTimer::timeout, this, &FilterProxy::startEvaluation);
+}
 
-struct LexToken {
-    LexKind kind;
-    QString text;   // for Word/CmpOp
-    qint64 number{}; // for Number
-};
+FilterProxy::~FilterProxy() {
+    cancelEvaluation();
+    m_pool.clear();
+    m_pool.waitForDone();
+}
 
-static bool isDelim(QChar c) {
-    return c.isSpace() || c == '&' || c == '|' || c == '<' || c == '>' || c == '=';
+void FilterProxy::setNeedle(const QString& text) {
+    const QString needle = text.trimmed();
+    if (needle == m_needle && !m_run && !m_debounce.isActive()) return;
+    m_needle = needle;
+
+    cancelEvaluation();
+
+    // Clearing the box is instant: no evaluation needed to show everything
+    if (m_needle.isEmpty()) {
+        m_debounce.stop();
+        m_plan = {};
+        m_binding = {};
+        m_accepted.clear();
+        m_resultValid = false;
+        setRows(allSourceRows());
+        emit evaluationFinished();
+        return;
+    }
+    m_debounce.start();
 }
 
-static bool isAllDigits(const QString& s) {
-    if (s.isEmpty()) return false;
-    for (QChar c : s) if (!c.isDigit()) return false;
-    return true;
+void FilterProxy::cancelEvaluation() {
+    if (!m_run) return;
+    m_run->cancelled = true;
+    m_run.reset();
 }
 
-static QVector<LexToken> lex(const QString& input) {
-    QVector<LexToken> out;
-    const QString s = input.trimmed();
-    int i = 0;
+void FilterProxy::startEvaluation() {
+    cancelEvaluation();
+    if (!m_model || m_needle.isEmpty()) return;
+
+    const SearchIndex& index = m_model->searchIndex();
+
+    auto run = std::make_shared<Run>();
+    run->timer.start();
+    run->needle = m_needle;
+    run->plan = QueryMatcher::compile(m_needle);
+    run->binding = run->plan.bind(index);
+    run->index = index;
+    run->stats = m_stats;
+
+    // Typing usually narrows the query. If the new plan refines the shown one and
+    // that result is still current, only its hits (plus rows carrying a grown text
+    // term as a tag) need checking.
+    QVector<int> widened;
+    if (!m_plan.isEmpty() && m_resultValid
+        && m_binding.generation == index.generation()
+        && run->plan.refines(m_plan, &widened))
+    {
+        run->domain = m_accepted;
+        for (int term : widened) run->domain |= index.rowsWithTag(run->binding.tagIds[term]);
+        run->restricted = true;
+    }
 
-    auto peek = [&](int off = 0) -> QChar {
-        const int k = i + off;
-        return (k >= 0 && k < s.size()) ? s[k] : QChar();
+    const int rows = index.rowCount();
+    const int threads = qMax(1, m_pool.maxThreadCount());
+    const int perSlice = qMax(1, (rows + threads - 1) / threads);
+    const int sliceRows = ((perSlice + kSliceRows - 1) / kSliceRows) * kSliceRows;
+    const int sliceCount = qMax(1, (rows + sliceRows - 1) / sliceRows);
+
+    run->slices.resize(sliceCount);
+    run->remaining = sliceCount;
+    m_run = run;
+
+    struct Job : public QRunnable {
+        QPointer<FilterProxy> proxy;
+        std::shared_ptr<Run> state;
+        int slice;
+        int begin;
+        int end;
+
+        Job(QPointer<FilterProxy> p, std::shared_ptr<Run> r, int s, int b, int e)
+            : proxy(p), state(std::move(r)), slice(s), begin(b), end(e) {}
+
+        void run() override {
+            Run& r = *state;
+            if (!r.cancelled) {
+                RowBitmap domain = RowBitmap::range(begin, end);
+                if (r.restricted) domain &= r.domain;
+                r.slices[slice] = r.plan.evaluate(r.index, r.binding, &domain, &r.cancelled, r.stats.get());
+            }
+            if (--r.remaining > 0 || r.cancelled) return;
+
+            // Last slice done: stitch (slices are disjoint and ordered) and hand over
+            RowBitmap accepted;
+            for (const RowBitmap& part : r.slices) accepted |= part;
+
+            QPointer<FilterProxy> p = proxy;
+            std::shared_ptr<Run> st = state;
+            QMetaObject::invokeMethod(p, [p, st, accepted]() {
+                if (!p) return;
+                p->publish(st, accepted);
+            }, Qt::QueuedConnection);
+        }
     };
 
-    while (i < s.size()) {
-        const QChar c = s[i];
-
-        if (c.isSpace()) { ++i; continue; }
-
-        if (c == '&') { out.push_back({LexKind::AndOp, "&", 0}); ++i; continue; }
-        if (c == '|') { out.push_back({LexKind::OrOp,  "|", 0}); ++i; continue; }
-
-        // Comparison operators: <= >= == < >
-        if (c == '<' || c == '>' || c == '=') {
-            QString op;
-            op += c;
-            if ((c == '<' || c == '>') && peek(1) == '=') { op += '='; i += 2; }
-            else if (c == '=' && peek(1) == '=') { op = "=="; i += 2; }
-            else { ++i; } // allows single '<' or '>' or (oddly) single '='
+    for (int i = 0; i < sliceCount; ++i) {
+        const int begin = i * sliceRows;
+        const int end = qMin(rows, begin + sliceRows);
+        auto* job = new Job(QPointer<FilterProxy>(this), run, i, begin, end);
+        job->setAutoDelete(true);
+        m_pool.start(job);
+    }
+}
 
-            out.push_back({LexKind::CmpOp, op, 0});
-            continue;
-        }
+void FilterProxy::publish(const std::shared_ptr<Run>& run, const RowBitmap& accepted) {
+    if (run != m_run || run->cancelled) return; // superseded meanwhile
+    m_run.reset();
 
-        // Read a "wordish" token until delimiter (allows dots, dashes, unicode, etc.)
-        int start = i;
-        while (i < s.size() && !isDelim(s[i])) ++i;
-        const QString token = s.mid(start, i - start);
+    // The model may have moved on while we ran; evaluate again rather than show stale rows
+    if (!m_model || run->binding.generation != m_model->searchIndex().generation()) {
+        startEvaluation();
+        return;
+    }
 
-        if (isAllDigits(token)) {
-            out.push_back({LexKind::Number, QString(), token.toLongLong()});
-        } else {
-            out.push_back({LexKind::Word, token, 0});
-        }
+    m_plan = run->plan;
+    m_binding = run->binding;
+    m_accepted = accepted;
+    m_resultValid = true;
+    setRows(accepted.toVector());
+
+    if (lcFilter().isDebugEnabled()) {
+        const int rows = run->restricted ? run->domain.cardinality() : run->index.rowCount();
+        const double ms = run->timer.nsecsElapsed() / 1e6;
+        qCDebug(lcFilter) << "filter" << run->needle << ":" << rows
+                          << (run->restricted ? "candidate rows in" : "rows in") << ms << "ms,"
+                          << (rows > 0 ? ms * 100000.0 / rows : 0.0) << "ms per 100k rows";
     }
 
-    return out;
+    emit evaluationFinished();
 }
 
-// ---------- Predicates / Compilation ----------
-
-enum class OpKind { And, Or };
-
-struct ProgTok {
-    // If pred is set -> predicate token; else operator token
-    std::function<bool(const FileItem&)> pred;
-    OpKind op{};
-    bool isPred = false;
-};
+void FilterProxy::setSourceModel(QAbstractItemModel* sm) {
+    if (sourceModel()) disconnect(sourceModel(), nullptr, this, nullptr);
+
+    beginResetModel();
+    cancelEvaluation();
+    QAbstractProxyModel::setSourceModel(sm);
+    m_model = qobject_cast<ThumbnailModel*>(sm);
+    m_binding = {};
+    m_accepted.clear();
+    m_resultValid = false;
+    m_rows = m_plan.isEmpty() ? allSourceRows() : QVector<int>();
+    m_currentPage = 1;
+    m_fetched = kFetchBatch;
+    endResetModel();
+
+    if (sm) {
+        connect(sm, &QAbstractItemModel::modelAboutToBeReset, this, &FilterProxy::onSourceAboutToBeReset);
+        connect(sm, &QAbstractItemModel::modelReset, this, &FilterProxy::onSourceReset);
+        connect(sm, &QAbstractItemModel::dataChanged, this, &FilterProxy::onSourceDataChanged);
+
+        // ThumbnailModel only ever resets; treat structural changes of other sources the same way
+        connect(sm, &QAbstractItemModel::rowsAboutToBeInserted, this, &FilterProxy::onSourceAboutToBeReset);
+        connect(sm, &QAbstractItemModel::rowsInserted, this, &FilterProxy::onSourceReset);
+        connect(sm, &QAbstractItemModel::rowsAboutToBeRemoved, this, &FilterProxy::onSourceAboutToBeReset);
+        connect(sm, &QAbstractItemModel::rowsRemoved, this, &FilterProxy::onSourceReset);
+        connect(sm, &QAbstractItemModel::layoutAboutToBeChanged, this, &FilterProxy::onSourceAboutToBeReset);
+        connect(sm, &QAbstractItemModel::layoutChanged, this, &FilterProxy::onSourceReset);
+    }
+    if (!m_needle.isEmpty()) startEvaluation();
+    emit pagingChanged();
+}
 
-static int precedence(OpKind op) {
-    // & has higher precedence than |
-    return (op == OpKind::And) ? 2 : 1;
+void FilterProxy::onSourceAboutToBeReset() {
+    beginResetModel();
+    cancelEvaluation();
 }
 
-static bool ciEquals(const QString& a, const QString& b) {
-    return a.compare(b, Qt::CaseInsensitive) == 0;
+void FilterProxy::onSourceReset() {
+    // Never show the previous folder's result against the new rows: with a needle
+    // the page stays empty until the new evaluation lands.
+    m_binding = {};
+    m_accepted.clear();
+    m_resultValid = false;
+    m_rows = m_plan.isEmpty() ? allSourceRows() : QVector<int>();
+    m_currentPage = 1;
+    m_fetched = kFetchBatch;
+    endResetModel();
+    emit pagingChanged();
+
+    if (!m_needle.isEmpty()) startEvaluation();
 }
 
-static bool tagsContainCI(const QStringList& tags, const QString& needle) {
-    for (const QString& t : tags) {
-        if (ciEquals(t, needle)) return true;
+// Query fields a dataChanged with these roles can affect; empty roles means any
+static quint8 fieldsOfRoles(const QVector<int>& roles) {
+    using namespace QueryMatcher;
+    if (roles.isEmpty()) return NameField | TagsField | KindField | YearField | SizeField;
+
+    quint8 f = NoField;
+    for (int role : roles) {
+        switch (role) {
+        case Qt::DisplayRole:
+        case ThumbnailModel::FileNameRole: f |= NameField; break;
+        case ThumbnailModel::TagsRole:     f |= TagsField; break;
+        case ThumbnailModel::FileKindRole: f |= KindField; break;
+        case ThumbnailModel::ModifiedRole: f |= YearField; break;
+        case ThumbnailModel::SizeRole:     f |= SizeField; break;
+        default: break; // thumbnails, placeholders, ...
+        }
     }
-    return false;
+    return f;
 }
 
-static std::function<bool(const FileItem&)> makeUnaryPredicate(const QString& rawToken) {
-    const QString tok = rawToken.trimmed();
-    const QString low = tok.toLower();
-
-    if (low == "picture") {
-        return [](const FileItem& it){ return it.kind == FileKind::Picture; };
+void FilterProxy::onSourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight,
+                                      const QVector<int>& roles) {
+    if (!topLeft.isValid() || !bottomRight.isValid()) return;
+
+    // Thumbnail streaming never gets past this: only fields the shown query reads count
+    if (!m_plan.isEmpty() && (m_plan.fields() & fieldsOfRoles(roles)))
+        recheckRows(topLeft.row(), bottomRight.row());
+
+    // Only rows on the current page are the view's business; thumbnails arriving
+    // for everything else cost a binary search each.
+    const int offset = windowOffset();
+    const int count = rowCount();
+    int first = -1, last = -1;
+    for (int src = topLeft.row(); src <= bottomRight.row(); ++src) {
+        const int r = positionOf(src) - offset;
+        if (r < 0 || r >= count) continue;
+        if (first < 0) first = r;
+        last = r;
     }
-    if (low == "video") {
-        return [](const FileItem& it){ return it.kind == FileKind::Video; };
-    }
-
-    // Default unary: filename contains OR tag equals (case-insensitive)
-    return [tok](const FileItem& it){
-        if (it.fileName.contains(tok, Qt::CaseInsensitive)) return true;
-        if (tagsContainCI(it.tags, tok)) return true;
-        return false;
-    };
+    if (first < 0) return;
+    emit dataChanged(index(first, topLeft.column()), index(last, bottomRight.column()), roles);
 }
 
-static bool evalCmp(qint64 left, const QString& op, qint64 right) {
-    if (op == "<")  return left <  right;
-    if (op == "<=") return left <= right;
-    if (op == ">")  return left >  right;
-    if (op == ">=") return left >= right;
-    if (op == "==") return left == right;
-    // If somebody typed weird stuff, fail closed.
-    return false;
-}
+void FilterProxy::recheckRows(int first, int last) {
+    // Nothing to patch while no result is shown or one is on its way: a run in
+    // flight started from an older index, and publish() re-evaluates when the
+    // generation moved meanwhile
+    if (!m_model || !m_resultValid || m_run) return;
+    const SearchIndex& index = m_model->searchIndex();
+    if (last >= index.rowCount()) return; // index not caught up; the next reset re-evaluates
 
-static std::function<bool(const FileItem&)> makeBinaryPredicate(
-    const QString& fieldRaw, const QString& cmpOp, qint64 value)
-{
-    const QString field = fieldRaw.toLower();
+    // The model updates its index before signalling, so a fresh binding sees new tags
+    if (m_binding.generation != index.generation()) m_binding = m_plan.bind(index);
 
-    if (field == "year") {
-        return [cmpOp, value](const FileItem& it){
-            const int y = it.modified.isValid() ? it.modified.date().year() : 0;
-            return evalCmp(y, cmpOp, value);
-        };
+    QVector<int> flipped;
+    for (int row = first; row <= last; ++row) {
+        if (m_plan.matches(index, m_binding, row) != m_accepted.contains(row)) flipped.push_back(row);
     }
-
-    if (field == "size") {
-        return [cmpOp, value](const FileItem& it){
-            return evalCmp(it.sizeBytes, cmpOp, value);
-        };
+    if (flipped.size() == 1) { // one file edited: keep scroll position and selection
+        const int row = flipped.first();
+        if (m_accepted.contains(row)) removeAccepted(row);
+        else insertAccepted(row);
+        return;
     }
+    if (flipped.isEmpty()) return;
 
-    // Unknown field => never matches
-    return [](const FileItem&){ return false; };
+    // Many at once (a tag renamed): one new row list instead of a splice per row
+    for (int row : flipped) {
+        if (m_accepted.contains(row)) m_accepted.remove(row);
+        else m_accepted.add(row);
+    }
+    setRows(m_accepted.toVector());
 }
 
-// Convert lex tokens -> infix predicate/operator stream, inserting implicit AND
-static QVector<ProgTok> toInfix(const QVector<LexToken>& ltoks) {
-    QVector<ProgTok> infix;
-
-    auto pushOp = [&](OpKind op){
-        infix.push_back(ProgTok{std::function<bool(const FileItem&)>(), op, false});
-    };
-    auto pushPred = [&](std::function<bool(const FileItem&)> p){
-        ProgTok t;
-        t.pred = std::move(p);
-        t.isPred = true;
-        infix.push_back(std::move(t));
-    };
-    auto isPrevPred = [&](){
-        return !infix.isEmpty() && infix.back().isPred;
-    };
-
-    for (int i = 0; i < ltoks.size(); ++i) {
-        const LexToken& t = ltoks[i];
-
-        if (t.kind == LexKind::AndOp) { pushOp(OpKind::And); continue; }
-        if (t.kind == LexKind::OrOp)  { pushOp(OpKind::Or);  continue; }
-
-        // Try to build (field cmp number): Word + CmpOp + Number
-        if (t.kind == LexKind::Word
-            && i + 2 < ltoks.size()
-            && ltoks[i + 1].kind == LexKind::CmpOp
-            && ltoks[i + 2].kind == LexKind::Number)
-        {
-            if (isPrevPred()) pushOp(OpKind::And); // implicit AND: "... <pred> year > 2021"
-            pushPred(makeBinaryPredicate(t.text, ltoks[i + 1].text, ltoks[i + 2].number));
-            i += 2;
-            continue;
-        }
-
-        // Unary token: Word or Number (numbers treated like text tokens too)
-        if (t.kind == LexKind::Word) {
-            if (isPrevPred()) pushOp(OpKind::And); // implicit AND on whitespace adjacency
-            pushPred(makeUnaryPredicate(t.text));
-            continue;
-        }
-
-        if (t.kind == LexKind::Number) {
-            if (isPrevPred()) pushOp(OpKind::And);
-            pushPred(makeUnaryPredicate(QString::number(t.number)));
-            continue;
-        }
-
-        // Lone comparison operator etc. => ignored (could also make whole query invalid)
-        // We'll just ignore it to avoid exploding on typos.
+void FilterProxy::insertAccepted(int sourceRow) {
+    m_accepted.add(sourceRow);
+    const int pos = int(std::lower_bound(m_rows.cbegin(), m_rows.cend(), sourceRow) - m_rows.cbegin());
+    const int shown = rowCount();
+    const int oldSize = m_rows.size();
+
+    if (m_scroll && (pos < shown || (pos == shown && m_fetched > shown))) {
+        beginInsertRows(QModelIndex(), pos, pos);
+        m_rows.insert(pos, sourceRow);
+        if (m_fetched <= oldSize) ++m_fetched; // keep the last shown row shown
+        endInsertRows();
+    } else if (!m_scroll && pos < windowOffset() + m_pageSize) {
+        // Shifts the rest of the page; a page is small
+        beginResetModel();
+        m_rows.insert(pos, sourceRow);
+        endResetModel();
+    } else {
+        m_rows.insert(pos, sourceRow);
     }
-
-    return infix;
+    emit pagingChanged();
 }
 
-// Shunting-yard: infix -> RPN (only binary ops, left-associative)
-static QVector<ProgTok> toRpn(const QVector<ProgTok>& infix, bool* okOut) {
-    QVector<ProgTok> output;
-    QStack<ProgTok> ops;
-    bool ok = true;
-
-    for (const ProgTok& t : infix) {
-        if (t.isPred) {
-            output.push_back(t);
-        } else {
-            // operator
-            while (!ops.isEmpty() && !ops.top().isPred
-                   && precedence(ops.top().op) >= precedence(t.op))
-            {
-                output.push_back(ops.pop());
-            }
-            ops.push(t);
-        }
-    }
-    while (!ops.isEmpty()) output.push_back(ops.pop());
-
-    // Basic sanity: RPN should be evaluatable
-    int stackDepth = 0;
-    for (const ProgTok& t : output) {
-        if (t.isPred) {
-            ++stackDepth;
-        } else {
-            // binary operator needs 2 operands
-            if (stackDepth < 2) { ok = false; break; }
-            --stackDepth; // consumes 2, produces 1
-        }
+void FilterProxy::removeAccepted(int sourceRow) {
+    m_accepted.remove(sourceRow);
+    const int pos = positionOf(sourceRow);
+    if (pos < 0) return;
+    const int oldSize = m_rows.size();
+
+    if (m_scroll && pos < rowCount()) {
+        beginRemoveRows(QModelIndex(), pos, pos);
+        m_rows.remove(pos);
+        if (m_fetched <= oldSize) --m_fetched;
+        endRemoveRows();
+    } else if (!m_scroll && pos < windowOffset() + m_pageSize) {
+        beginResetModel();
+        m_rows.remove(pos);
+        m_currentPage = qBound(1, m_currentPage, totalPages());
+        endResetModel();
+    } else {
+        m_rows.remove(pos);
     }
-    if (stackDepth != 1 && !output.isEmpty()) ok = false;
-
-    if (okOut) *okOut = ok;
-    return output;
+    emit pagingChanged();
 }
 
-// ---------- Evaluation ----------
-
-static bool evalRpn(const QVector<ProgTok>& rpn, const FileItem& item, bool* okOut) {
-    if (rpn.isEmpty()) { if (okOut) *okOut = true; return true; } // empty query matches all
-
-    QStack<bool> st;
-    bool ok = true;
-
-    for (const ProgTok& t : rpn) {
-        if (t.isPred) {
-            st.push(t.pred ? t.pred(item) : false);
-        } else {
-            if (st.size() < 2) { ok = false; break; }
-            const bool b = st.pop();
-            const bool a = st.pop();
-            const bool r = (t.op == OpKind::And) ? (a && b) : (a || b);
-            st.push(r);
-        }
-    }
+QVector<int> FilterProxy::allSourceRows() const {
+    QVector<int> rows(sourceModel() ? sourceModel()->rowCount() : 0);
+    std::iota(rows.begin(), rows.end(), 0);
+    return rows;
+}
 
-    if (st.size() != 1) ok = false;
-    if (okOut) *okOut = ok;
-    return ok ? st.top() : false;
+int FilterProxy::positionOf(int sourceRow) const {
+    auto it = std::lower_bound(m_rows.cbegin(), m_rows.cend(), sourceRow);
+    if (it == m_rows.cend() || *it != sourceRow) return -1;
+    return int(it - m_rows.cbegin());
 }
 
-// Public API
-inline bool matches(const FileItem& item, const QString& query) {
-    const QString q = query.trimmed();
-    if (q.isEmpty()) return true;
+void FilterProxy::setRows(QVector<int> rows) {
+    beginResetModel();
+    m_rows = std::move(rows);
+    m_currentPage = qBound(1, m_currentPage, totalPages());
+    m_fetched = kFetchBatch;
+    endResetModel();
+    emit pagingChanged();
+}
 
-    const QVector<LexToken> lt = lex(q);
-    const QVector<ProgTok> infix = toInfix(lt);
+// ---------- Proxy plumbing ----------
 
-    bool okCompile = true;
-    const QVector<ProgTok> rpn = toRpn(infix, &okCompile);
+int FilterProxy::columnCount(const QModelIndex& parent) const {
+    if (parent.isValid() || !sourceModel()) return 0;
+    return sourceModel()->columnCount();
+}
 
-    bool okEval = true;
-    const bool result = evalRpn(rpn, item, &okEval);
+int FilterProxy::rowCount(const QModelIndex& parent) const {
+    if (parent.isValid() || !sourceModel()) return 0;
+    if (m_scroll) return qMin(m_fetched, m_rows.size());
+    const int start = windowOffset();
+    const int end = qMin(start + m_pageSize, m_rows.size());
+    return qMax(0, end - start);
+}
 
-    // If user typed nonsense, do something predictable: match by raw text as a unary token.
-    if (!okCompile || !okEval) {
-        return makeUnaryPredicate(q)(item);
-    }
+QModelIndex FilterProxy::index(int row, int col, const QModelIndex& parent) const {
+    if (parent.isValid()) return {};
+    if (row < 0 || col < 0) return {};
+    if (row >= rowCount() || col >= columnCount()) return {};
+    return createIndex(row, col);
+}
 
-    return result;
+QModelIndex FilterProxy::mapToSource(const QModelIndex& proxyIndex) const {
+    if (!sourceModel() || !proxyIndex.isValid()) return {};
+    const int pos = windowOffset() + proxyIndex.row();
+    if (pos < 0 || pos >= m_rows.size()) return {};
+    return sourceModel()->index(m_rows[pos], proxyIndex.column());
 }
 
-} // namespace QueryMatcher
+QModelIndex FilterProxy::mapFromSource(const QModelIndex& sourceIndex) const {
+    if (!sourceModel() || !sourceIndex.isValid()) return {};
+    const int r = positionOf(sourceIndex.row()) - windowOffset();
+    if (r < 0 || r >= rowCount()) return {};
+    return index(r, sourceIndex.column());
+}
 
+QVariant FilterProxy::data(const QModelIndex& idx, int role) const {
+    return sourceModel() ? sourceModel()->data(mapToSource(idx), role) : QVariant{};
+}
 
+// ---------- Window ----------
 
-FilterProxy::FilterProxy(QObject* parent) : QSortFilterProxyModel(parent) {
-    setFilterCaseSensitivity(Qt::CaseInsensitive);
-    setSortCaseSensitivity(Qt::CaseInsensitive);
+bool FilterProxy::canFetchMore(const QModelIndex& parent) const {
+    return !parent.isValid() && m_scroll && m_fetched < m_rows.size();
 }
 
-void FilterProxy::setNeedle(const QString& text) {
-    m_needle = text.trimmed();
-    invalidateFilter();
+void FilterProxy::fetchMore(const QModelIndex& parent) {
+    if (!canFetchMore(parent)) return;
+    const int first = rowCount();
+    const int last = qMin(m_rows.size(), first + kFetchBatch) - 1;
+    beginInsertRows(QModelIndex(), first, last);
+    m_fetched = last + 1;
+    endInsertRows();
 }
 
-bool FilterProxy::filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const {
-    if (m_needle.isEmpty()) return true;
-
-    QModelIndex idx = sourceModel()->index(sourceRow, 0, sourceParent);
-    const QString name = sourceModel()->data(idx, ThumbnailModel::FileNameRole).toString();
-    const QDateTime modified = sourceModel()->data(idx, ThumbnailModel::ModifiedRole).toDateTime();
-    const qint64 size = sourceModel()->data(idx, ThumbnailModel::SizeRole).toLongLong();
-    const QStringList tags = sourceModel()->data(idx, ThumbnailModel::TagsRole).toStringList();
-    const FileKind kind = static_cast<FileKind>(sourceModel()->data(idx, ThumbnailModel::FileKindRole).toInt());
+void FilterProxy::setScrollMode(bool on) {
+    if (m_scroll == on) return;
+    beginResetModel();
+    m_scroll = on;
+    m_fetched = kFetchBatch;
+    endResetModel();
+    emit pagingChanged();
+}
 
-    auto item = FileItem();
-    item.fileName = name;
-    item.modified = modified;
-    item.sizeBytes = size;
-    item.tags = tags;
-    item.kind = kind;
+void FilterProxy::setPageSize(int ps) {
+    ps = qMax(1, ps);
+    if (m_pageSize == ps) return;
+    beginResetModel();
+    m_pageSize = ps;
+    m_currentPage = 1;
+    endResetModel();
+    emit pagingChanged();
+}
 
-    return QueryMatcher::matches(item, m_needle);
+int FilterProxy::totalPages() const {
+    const int items = totalItems();
+    if (items <= 0) return 1;
+    return qMax(1, (items + m_pageSize - 1) / m_pageSize);
 }
 
+void FilterProxy::setCurrentPage(int page) {
+    page = qBound(1, page, totalPages());
+    if (m_currentPage == page) return;
+    if (m_scroll) { // the window does not depend on it
+        m_currentPage = page;
+        emit pagingChanged();
+        return;
+    }
+    beginResetModel();
+    m_currentPage = page;
+    endResetModel();
+    emit pagingChanged();
+}
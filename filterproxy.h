@@ -3,19 +3,113 @@
 
 // FilterProxy.h
 #pragma once
-#include <QSortFilterProxyModel>
+#include <QAbstractProxyModel>
+#include <QPointer>
+#include <QThreadPool>
+#include <QTimer>
+#include <memory>
+#include "querymatcher.h"
 
-class FilterProxy : public QSortFilterProxyModel {
+class ThumbnailModel;
+
+// Filter and pager in one: holds the filtered source rows as a single ascending
+// vector and exposes a window of it, so a view index maps to the source with a
+// single array lookup. The window is one page, or in scroll mode the whole
+// result, handed to the view in batches through canFetchMore()/fetchMore().
+class FilterProxy : public QAbstractProxyModel {
     Q_OBJECT
 public:
     explicit FilterProxy(QObject* parent = nullptr);
+    ~FilterProxy() override;
+
+    // Evaluated in the background (debounced, cancellable); the current result
+    // stays visible until the new one is published.
     void setNeedle(const QString& text);
 
-protected:
-    bool filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const override;
+    void setSourceModel(QAbstractItemModel* sourceModel) override;
+
+    QModelIndex mapToSource(const QModelIndex& proxyIndex) const override;
+    QModelIndex mapFromSource(const QModelIndex& sourceIndex) const override;
+
+    int rowCount(const QModelIndex& parent = {}) const override;
+    int columnCount(const QModelIndex& parent = {}) const override;
+
+    QModelIndex index(int row, int col, const QModelIndex& parent = {}) const override;
+    QModelIndex parent(const QModelIndex&) const override { return {}; }
+
+    QVariant data(const QModelIndex& index, int role) const override;
+
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+    // Off: pages of pageSize() rows. On: one list over the whole result; paging calls
+    // only track the page number.
+    void setScrollMode(bool on);
+    bool scrollMode() const { return m_scroll; }
+
+    void setPageSize(int pageSize);
+    int pageSize() const { return m_pageSize; }
+
+    void setCurrentPage(int page); // 1-based
+    int currentPage() const { return m_currentPage; }
+
+    int totalItems() const { return m_rows.size(); }
+    int totalPages() const;
+
+    // Source rows of the whole filtered result, ascending
+    const QVector<int>& acceptedRows() const { return m_rows; }
+    bool isEvaluating() const { return bool(m_run); }
+
+signals:
+    void pagingChanged();
+    void evaluationFinished();
 
 private:
+    struct Run;
+
+    void startEvaluation();
+    void cancelEvaluation();
+    void publish(const std::shared_ptr<Run>& run, const RowBitmap& accepted);
+
+    void setRows(QVector<int> rows); // resets the view, keeps the page if still valid
+    QVector<int> allSourceRows() const;
+    int windowOffset() const { return m_scroll ? 0 : (m_currentPage - 1) * m_pageSize; }
+    int positionOf(int sourceRow) const; // index into m_rows, -1 if filtered out
+
+    void onSourceAboutToBeReset();
+    void onSourceReset();
+    void onSourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight,
+                             const QVector<int>& roles);
+    void recheckRows(int first, int last); // source rows whose queryable fields changed
+    void insertAccepted(int sourceRow);
+    void removeAccepted(int sourceRow);
+
     QString m_needle;
+    QTimer m_debounce;
+
+    // What the view currently shows: plan, the index generation it was evaluated
+    // against, and its result (bitmap for refinement, rows for mapping).
+    QueryMatcher::Plan m_plan;
+    QueryMatcher::Binding m_binding;
+    RowBitmap m_accepted;
+    QVector<int> m_rows;
+    // m_accepted is m_plan's whole result at m_binding's generation. Not after a
+    // source reset until the next publish: rows are then empty, not a result.
+    bool m_resultValid = false;
+
+    int m_pageSize = 60;
+    int m_currentPage = 1;
+
+    bool m_scroll = false;
+    int m_fetched = 0; // scroll mode: rows exposed so far (may exceed m_rows.size())
+
+    // Term pass rates seen so far; orders AND/OR operands of later queries
+    std::shared_ptr<QueryMatcher::Selectivity> m_stats = std::make_shared<QueryMatcher::Selectivity>();
+
+    std::shared_ptr<Run> m_run; // in flight, null when idle
+    QThreadPool m_pool;
+
+    QPointer<ThumbnailModel> m_model; // typed source, null for other models
 };
 
 
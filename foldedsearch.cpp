@@ -0,0 +1,163 @@
+#include "foldedsearch.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define FOLDEDSEARCH_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define FOLDEDSEARCH_TARGET(isa)
+#else
+#define FOLDEDSEARCH_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+namespace FoldedSearch {
+
+// ---------- Folding ----------
+
+QString fold(const QString& s) {
+    const QChar* p = s.constData();
+    const qsizetype n = s.size();
+    for (qsizetype i = 0; i < n; ++i) {
+        if (p[i].unicode() >= 0x80) return s.toCaseFolded();
+    }
+
+    // ASCII: folding is lower-casing A-Z
+    QString out(n, Qt::Uninitialized);
+    QChar* o = out.data();
+    for (qsizetype i = 0; i < n; ++i) {
+        const char16_t c = p[i].unicode();
+        o[i] = QChar(char16_t(unsigned(c - 'A') < 26u ? c | 0x20 : c));
+    }
+    return out;
+}
+
+// ---------- Kernels ----------
+
+// All kernels take n >= m >= 1.
+using Kernel = qsizetype (*)(const char16_t* h, qsizetype n, const char16_t* nd, qsizetype m);
+
+static bool equalUnits(const char16_t* a, const char16_t* b, qsizetype len) {
+    return len <= 0 || std::memcmp(a, b, size_t(len) * sizeof(char16_t)) == 0;
+}
+
+static qsizetype findScalarFrom(const char16_t* h, qsizetype n, const char16_t* nd, qsizetype m, qsizetype from) {
+    const char16_t first = nd[0];
+    for (qsizetype i = from; i + m <= n; ++i) {
+        if (h[i] == first && equalUnits(h + i + 1, nd + 1, m - 1)) return i;
+    }
+    return -1;
+}
+
+static qsizetype findScalar(const char16_t* h, qsizetype n, const char16_t* nd, qsizetype m) {
+    return findScalarFrom(h, n, nd, m, 0);
+}
+
+#ifdef FOLDEDSEARCH_X86
+
+static int lowestBit(unsigned v) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward(&idx, v);
+    return int(idx);
+#else
+    return __builtin_ctz(v);
+#endif
+}
+
+// Compare the first and last needle unit against a whole block of candidate
+// starts at once; only starts where both agree get a full compare.
+FOLDEDSEARCH_TARGET("sse2")
+static qsizetype findSse2(const char16_t* h, qsizetype n, const char16_t* nd, qsizetype m) {
+    const __m128i first = _mm_set1_epi16(short(nd[0]));
+    const __m128i last = _mm_set1_epi16(short(nd[m - 1]));
+
+    qsizetype i = 0;
+    for (; i + m - 1 + 8 <= n; i += 8) {
+        const __m128i bf = _mm_loadu_si128(reinterpret_cast<const __m128i*>(h + i));
+        const __m128i bl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(h + i + m - 1));
+        unsigned mask = unsigned(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi16(bf, first), _mm_cmpeq_epi16(bl, last))));
+        while (mask) {
+            const int lane = lowestBit(mask) / 2; // two mask bits per 16-bit lane
+            if (equalUnits(h + i + lane + 1, nd + 1, m - 2)) return i + lane;
+            mask &= ~(3u << (lane * 2));
+        }
+    }
+    return findScalarFrom(h, n, nd, m, i);
+}
+
+FOLDEDSEARCH_TARGET("avx2")
+static qsizetype findAvx2(const char16_t* h, qsizetype n, const char16_t* nd, qsizetype m) {
+    const __m256i first = _mm256_set1_epi16(short(nd[0]));
+    const __m256i last = _mm256_set1_epi16(short(nd[m - 1]));
+
+    qsizetype i = 0;
+    for (; i + m - 1 + 16 <= n; i += 16) {
+        const __m256i bf = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(h + i));
+        const __m256i bl = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(h + i + m - 1));
+        unsigned mask = unsigned(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi16(bf, first), _mm256_cmpeq_epi16(bl, last))));
+        while (mask) {
+            const int lane = lowestBit(mask) / 2;
+            if (equalUnits(h + i + lane + 1, nd + 1, m - 2)) return i + lane;
+            mask &= ~(3u << (lane * 2));
+        }
+    }
+    // Short names never reach the loop above; SSE2 still covers 8..15 units
+    return i == 0 ? findSse2(h, n, nd, m) : findScalarFrom(h, n, nd, m, i);
+}
+
+static bool cpuHasAvx2() {
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 1);
+    const bool osxsave = regs[2] & (1 << 27);
+    if (!osxsave || (_xgetbv(0) & 6) != 6) return false; // OS saves YMM state
+    __cpuidex(regs, 7, 0);
+    return regs[1] & (1 << 5);
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // FOLDEDSEARCH_X86
+
+struct Dispatch {
+    Kernel kernel = findScalar;
+    const char* name = "scalar";
+
+    Dispatch() {
+#ifdef FOLDEDSEARCH_X86
+        // SSE2 is baseline on every x86 CPU Qt 5/6 runs on
+        kernel = findSse2;
+        name = "sse2";
+        if (cpuHasAvx2()) {
+            kernel = findAvx2;
+            name = "avx2";
+        }
+#endif
+    }
+};
+
+static const Dispatch& dispatch() {
+    static const Dispatch d;
+    return d;
+}
+
+qsizetype indexOf(QStringView haystack, QStringView needle) {
+    const qsizetype m = needle.size();
+    const qsizetype n = haystack.size();
+    if (m == 0) return 0;
+    if (m > n) return -1;
+    return dispatch().kernel(haystack.utf16(), n, needle.utf16(), m);
+}
+
+const char* kernelName() {
+    return dispatch().name;
+}
+
+} // namespace FoldedSearch
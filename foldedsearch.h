@@ -0,0 +1,30 @@
+#ifndef FOLDEDSEARCH_H
+#define FOLDEDSEARCH_H
+
+#pragma once
+#include <QString>
+#include <QStringView>
+
+// Case-insensitive search, split in two: fold() once when text enters an index,
+// then plain code-unit search over the folded buffers. The search uses AVX2 or
+// SSE2 when the CPU has them (picked once at runtime) and a scalar loop otherwise.
+namespace FoldedSearch {
+
+// Same result as QString::toCaseFolded(); pure ASCII (the common file name)
+// skips the Unicode tables.
+QString fold(const QString& s);
+
+// First position of needle in haystack, -1 if absent; empty needle matches at 0.
+// Both sides must be fold()ed for case-insensitive semantics.
+qsizetype indexOf(QStringView haystack, QStringView needle);
+
+inline bool contains(QStringView haystack, QStringView needle) {
+    return indexOf(haystack, needle) >= 0;
+}
+
+// "avx2", "sse2" or "scalar": the kernel indexOf() dispatches to
+const char* kernelName();
+
+} // namespace FoldedSearch
+
+#endif // FOLDEDSEARCH_H
@@ -7,25 +7,34 @@
 #include <QLineEdit>
 #include <QLabel>
 #include <QToolBar>
+#include <QStatusBar>
 #include <QAction>
 #include <QFileDialog>
+#include <QInputDialog>
+#include <QMessageBox>
 #include <QItemSelectionModel>
 #include <QToolButton>
 #include <QStandardPaths>
 #include <QDir>
 #include <QFileIconProvider>
 #include <QDateTime>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QTimer>
 #include <optional>
 
 #include "workspacelistmodel.h"
 #include "thumbnailmodel.h"
 #include "filterproxy.h"
-#include "pagedproxy.h"
 #include "paginationbar.h"
+#include "thumbnailprefetcher.h"
 #include "thumbnaildelegate.h"
 #include "filedetailstab.h"
 #include "fileitem.h"
 #include "picturedetailstab.h"
+#include "querymatcher.h"
+#include "sidecarimporter.h"
+#include "tagcompleter.h"
 #include "videodetailstab.h"
 
 static QDateTime bestEffortCreatedTime(const QFileInfo& fi) {
@@ -45,23 +54,53 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
     const QString cfgDir = QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation);
     QDir().mkpath(cfgDir);
 
+    // Opens in the background. If the DB fails, the app can still run, but
+    // persistence/tags won't work (reads come back empty).
     m_store = new TaggerStore(this);
-    if (!m_store->openOrCreate(cfgDir + "/tagger.db")) {
-        // If DB fails, app can still run, but persistence/tags won't work.
-        // You can show a QMessageBox if you want.
-    }
+    m_store->openOrCreate(cfgDir + "/tagger.db");
 
     m_hasher = new FileHasher(m_store, this);
+    // Bulk tagging hashes its files as one batch; their hashes get the tags in chunks
+    connect(m_hasher, &FileHasher::batchHashed, m_store, &TaggerStore::copyPathTagsToHashes);
+    m_sidecars = new SidecarImporter(m_store, this);
+    connect(m_sidecars, &SidecarImporter::imported, this, [this](const QString& root, int files) {
+        statusBar()->showMessage(QString("Imported sidecar tags of %1 file(s) in %2").arg(files).arg(root), 5000);
+    });
+    new TagCompleter(m_store->tagDictionary(), m_search, TagCompleter::Mode::Query);
     if (m_thumbModel) {
         m_thumbModel->setStore(m_store);
     }
 
-    QVector<Workspace> workspaces;
-    if (m_store) {
-        const auto stored = m_store->loadWorkspaces();
-        for (const auto& rec : stored) {
-            workspaces.push_back({rec.name, rec.dir});
+    // Saved state is read off the GUI thread; the (empty) window shows meanwhile
+    TaggerStore* store = m_store;
+    m_store->read(this, [store] {
+        StartupState state;
+        state.scrollMode = store->getState("grid/scrollMode");
+        state.workspaces = store->loadWorkspaces();
+        for (const QString& path : store->loadOpenTabs()) {
+            if (auto item = fileItemForTab(path, store)) state.tabs.push_back(std::move(*item));
+            else state.missingTabs << path;
         }
+        return state;
+    }, [this](const StartupState& state) { applyStartupState(state); });
+}
+
+MainWindow::~MainWindow() {
+    // Hash and import jobs use the store; stop them before it goes
+    delete m_hasher;
+    m_hasher = nullptr;
+    delete m_sidecars;
+    m_sidecars = nullptr;
+}
+
+void MainWindow::applyStartupState(const StartupState& state) {
+    if (state.scrollMode) {
+        m_scrollModeAction->setChecked(*state.scrollMode == "1");
+    }
+
+    QVector<Workspace> workspaces;
+    for (const auto& rec : state.workspaces) {
+        workspaces.push_back({rec.name, rec.dir});
     }
     if (workspaces.isEmpty()) {
         const QString homeDir = QDir::homePath();
@@ -80,7 +119,7 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
         setWorkspaceDirectory(m_workspaceModel->data(m_workspaceModel->index(0,0), WorkspaceListModel::DirRole).toString());
     }
 
-    restoreOpenTabs();
+    restoreOpenTabs(state);
 }
 
 void MainWindow::buildUi() {
@@ -201,6 +240,75 @@ void MainWindow::buildUi() {
         if (dir.isEmpty()) return;
         addWorkspaceAndSelect(dir);
     });
+
+    // Sidecars are imported when a workspace is added and then folder by folder as
+    // they are listed; this picks up ones written by other tools meanwhile
+    auto* reimport = tb->addAction("Re-import Sidecars");
+    connect(reimport, &QAction::triggered, this, [this]{
+        if (m_currentDir.isEmpty()) return;
+        m_sidecars->importWorkspace(m_currentDir);
+    });
+
+    m_scrollModeAction = tb->addAction("Infinite Scroll");
+    m_scrollModeAction->setCheckable(true);
+    connect(m_scrollModeAction, &QAction::toggled, this, [this](bool on){
+        m_filter->setScrollMode(on);
+        m_pager->setVisible(!on);
+        m_thumbView->scrollToTop();
+        if (m_store) m_store->setState("grid/scrollMode", on ? "1" : "0");
+    });
+
+    // Library-wide tag edits; the store rewrites every record in one transaction
+    auto* renameTag = tb->addAction("Rename Tag…");
+    connect(renameTag, &QAction::triggered, this, [this]{
+        if (!m_store) return;
+        const QString from = QInputDialog::getText(this, "Rename Tag", "Tag:").trimmed();
+        if (from.isEmpty()) return;
+        const QString to = QInputDialog::getText(this, "Rename Tag",
+                                                 "New name (an existing tag is merged into):",
+                                                 QLineEdit::Normal, from).trimmed();
+        if (to.isEmpty() || to == from) return;
+        m_store->renameTag(from, to);
+    });
+
+    auto* deleteTag = tb->addAction("Delete Tag…");
+    connect(deleteTag, &QAction::triggered, this, [this]{
+        if (!m_store) return;
+        const QString name = QInputDialog::getText(this, "Delete Tag", "Tag:").trimmed();
+        if (name.isEmpty()) return;
+        const int files = m_store->tagDictionary()->count(name);
+        if (QMessageBox::question(this, "Delete Tag",
+                                  QString("Remove \"%1\" from %2 file(s)?").arg(name).arg(files))
+            != QMessageBox::Yes) return;
+        m_store->deleteTag(name);
+    });
+
+    // Bulk tagging of the grid's selection: one write, however many files
+    auto* addTags = tb->addAction("Add Tags to Selection…");
+    connect(addTags, &QAction::triggered, this, [this]{
+        tagSelection(askForTags("Add Tags", "Tags to add (comma-separated):"), true);
+    });
+
+    auto* removeTags = tb->addAction("Remove Tags from Selection…");
+    connect(removeTags, &QAction::triggered, this, [this]{
+        tagSelection(askForTags("Remove Tags", "Tags to remove (comma-separated):"), false);
+    });
+
+    // Global search: the search box queries the catalog of every scanned folder
+    // instead of filtering the current one
+    m_globalSearchAction = tb->addAction("Search All Workspaces");
+    m_globalSearchAction->setCheckable(true);
+    connect(m_globalSearchAction, &QAction::toggled, this, [this](bool on){
+        if (on) {
+            m_tabs->setTabText(m_mainTabIndex, "Main (all workspaces)");
+            runGlobalSearch();
+        } else {
+            ++m_globalSearchSerial; // drop results still on their way
+            m_tabs->setTabText(m_mainTabIndex, QString("Main (%1)").arg(QFileInfo(m_currentDir).fileName()));
+            m_thumbModel->setDirectory(m_currentDir);
+        }
+        m_filter->setCurrentPage(1);
+    });
 }
 
 QWidget* MainWindow::buildMainTab() {
@@ -217,7 +325,7 @@ QWidget* MainWindow::buildMainTab() {
     m_thumbView->setMovement(QListView::Static);
     m_thumbView->setWrapping(true);
     m_thumbView->setWordWrap(false);
-    m_thumbView->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_thumbView->setSelectionMode(QAbstractItemView::ExtendedSelection);
     m_thumbView->setSpacing(10);
     m_thumbView->setUniformItemSizes(true);
 
@@ -230,38 +338,44 @@ QWidget* MainWindow::buildMainTab() {
     m_pager = new PaginationBar(w);
     layout->addWidget(m_pager);
 
-    // Models: base -> filter -> paged -> view
+    // Models: base -> filter/pager -> view
     m_thumbModel = new ThumbnailModel(this);
     m_thumbModel->setStore(m_store);
 
     m_filter = new FilterProxy(this);
     m_filter->setSourceModel(m_thumbModel);
+    m_filter->setPageSize(60);
+
+    m_thumbView->setModel(m_filter);
 
-    m_paged = new PagedProxy(this);
-    m_paged->setSourceModel(m_filter);
-    m_paged->setPageSize(60);
+    // Thumbnails are only decoded for what is on (or about to come on) screen
+    new ThumbnailPrefetcher(m_thumbView, m_filter, m_thumbModel, m_thumbView);
 
-    m_thumbView->setModel(m_paged);
+    m_globalSearchTimer = new QTimer(this);
+    m_globalSearchTimer->setSingleShot(true);
+    m_globalSearchTimer->setInterval(150); // one query per typing pause
+    connect(m_globalSearchTimer, &QTimer::timeout, this, &MainWindow::runGlobalSearch);
 
     connect(m_search, &QLineEdit::textChanged, this, [this](const QString& t){
+        // Global results are re-filtered with the same query, so the grid shows
+        // the local semantics either way
         m_filter->setNeedle(t);
-        m_paged->setCurrentPage(1);
+        m_filter->setCurrentPage(1);
+        if (m_globalSearchAction && m_globalSearchAction->isChecked()) m_globalSearchTimer->start();
     });
 
-    connect(m_paged, &PagedProxy::pagingChanged, this, [this]{
-        m_pager->setPageInfo(m_paged->currentPage(), m_paged->totalPages());
+    connect(m_filter, &FilterProxy::pagingChanged, this, [this]{
+        m_pager->setPageInfo(m_filter->currentPage(), m_filter->totalPages());
     });
 
     connect(m_pager, &PaginationBar::pageRequested, this, [this](int page){
-        m_paged->setCurrentPage(page);
+        m_filter->setCurrentPage(page);
     });
 
     connect(m_thumbView, &QListView::doubleClicked, this, [this](const QModelIndex& proxyIdx){
         if (!proxyIdx.isValid()) return;
 
-        // map: paged proxy -> filter source -> thumbnail model source
-        const QModelIndex filterIdx = m_paged->mapToSource(proxyIdx);
-        const QModelIndex srcIdx = m_filter->mapToSource(filterIdx);
+        const QModelIndex srcIdx = m_filter->mapToSource(proxyIdx);
 
         const auto kindValue = m_thumbModel->data(srcIdx, ThumbnailModel::FileKindRole).toInt();
         const auto kind = static_cast<FileKind>(kindValue);
@@ -314,6 +428,55 @@ bool MainWindow::openFileTab(const FileItem& item, bool setCurrent, bool persist
     return true;
 }
 
+QStringList MainWindow::askForTags(const QString& title, const QString& label) {
+    QDialog dialog(this);
+    dialog.setWindowTitle(title);
+    auto* layout = new QVBoxLayout(&dialog);
+    layout->addWidget(new QLabel(label, &dialog));
+    auto* edit = new QLineEdit(&dialog);
+    if (m_store) new TagCompleter(m_store->tagDictionary(), edit, TagCompleter::Mode::TagList);
+    layout->addWidget(edit);
+    auto* buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    layout->addWidget(buttons);
+    if (dialog.exec() != QDialog::Accepted) return {};
+
+    QStringList tags;
+    for (const QString& t : edit->text().split(',', Qt::SkipEmptyParts)) {
+        const QString trimmed = t.trimmed();
+        if (!trimmed.isEmpty() && !tags.contains(trimmed)) tags << trimmed;
+    }
+    return tags;
+}
+
+void MainWindow::tagSelection(const QStringList& tags, bool add) {
+    if (!m_store || tags.isEmpty()) return;
+
+    QVector<TaggerStore::TagEdit> edits;
+    QStringList paths;
+    for (const QModelIndex& proxyIdx : m_thumbView->selectionModel()->selectedIndexes()) {
+        const QModelIndex srcIdx = m_filter->mapToSource(proxyIdx);
+        if (!srcIdx.isValid()) continue;
+        const FileItem& item = m_thumbModel->itemAt(srcIdx.row());
+        if (item.kind == FileKind::Directory || item.absolutePath.isEmpty()) continue;
+
+        QStringList now = item.tags;
+        for (const QString& t : tags) {
+            if (add && !now.contains(t)) now << t;
+            else if (!add) now.removeAll(t);
+        }
+        if (now == item.tags) continue; // already so: no write, no rehash
+        edits.push_back({item.absolutePath, now, item.tags});
+        paths << item.absolutePath;
+    }
+    if (edits.isEmpty()) return;
+
+    // The grid follows through tagsChanged; hash records once the batch is hashed
+    m_store->upsertTagsByPath(edits);
+    if (m_hasher) m_hasher->requestBatch(paths);
+}
+
 QWidget* MainWindow::createDetailsTab(const FileItem& item) {
     QWidget* tab = nullptr;
     switch (item.kind) {
@@ -369,38 +532,35 @@ bool MainWindow::navigateDetailsTab(QWidget* tab, int direction) {
     return true;
 }
 
-bool MainWindow::openFileTab(const QString& path, bool setCurrent, bool persist) {
+std::optional<FileItem> MainWindow::fileItemForTab(const QString& path, TaggerStore* store) {
     const QFileInfo fi(path);
-    if (!fi.exists()) return false;
+    if (!fi.exists()) return std::nullopt;
 
     FileItem item;
     item.absolutePath = fi.absoluteFilePath();
     item.fileName = fi.fileName();
     item.kind = classifyFileKind(fi);
-    if (item.kind == FileKind::Directory) return false;
+    if (item.kind == FileKind::Directory) return std::nullopt;
     item.modified = fi.lastModified();
     item.created = bestEffortCreatedTime(fi);
     item.sizeBytes = fi.size();
 
-    QFileIconProvider iconProvider;
-    item.icon = iconProvider.icon(fi);
-
-    if (m_store) {
-        if (auto tags = m_store->getTagsByPath(item.absolutePath)) {
+    if (store) {
+        if (auto tags = store->getTagsByPath(item.absolutePath)) {
             item.tags = *tags;
         }
     }
-
-    return openFileTab(item, setCurrent, persist);
+    return item;
 }
 
-void MainWindow::restoreOpenTabs() {
-    if (!m_store) return;
-    const QStringList tabs = m_store->loadOpenTabs();
-    for (const auto& path : tabs) {
-        if (!openFileTab(path, false, false)) {
-            m_store->removeOpenTab(path);
-        }
+void MainWindow::restoreOpenTabs(const StartupState& state) {
+    QFileIconProvider iconProvider; // GUI thread only, so icons are filled in here
+    for (FileItem item : state.tabs) {
+        item.icon = iconProvider.icon(QFileInfo(item.absolutePath));
+        openFileTab(item, false, false);
+    }
+    for (const auto& path : state.missingTabs) {
+        m_store->removeOpenTab(path);
     }
 }
 
@@ -410,16 +570,47 @@ void MainWindow::addWorkspaceAndSelect(const QString& dir) {
     const QString name = fi.fileName().isEmpty() ? fi.absoluteFilePath() : fi.fileName();
     m_workspaceModel->addWorkspace({name, dir});
     if (m_store) m_store->upsertWorkspace(dir, name);
+    m_sidecars->importWorkspace(dir);
     const int row = m_workspaceModel->indexOfDir(dir);
     if (row >= 0) {
         m_workspaceView->setCurrentIndex(m_workspaceModel->index(row, 0));
     }
 }
 
+void MainWindow::runGlobalSearch() {
+    const int serial = ++m_globalSearchSerial;
+    const QueryMatcher::Plan plan = QueryMatcher::compile(m_search->text());
+    if (plan.isEmpty() || !m_store) {
+        m_thumbModel->showFiles({}, {}); // no query, no results: not the whole library
+        return;
+    }
+
+    TaggerStore* store = m_store;
+    m_store->read(this, [store, plan] {
+        GlobalResults results;
+        const QVector<FileItem> hits = store->searchCatalog(plan, kGlobalSearchLimit);
+        for (const FileItem& item : hits) {
+            const QFileInfo fi(item.absolutePath);
+            if (!fi.exists()) continue; // moved or deleted since its folder was scanned
+            results.items.push_back(item);
+            results.infos.push_back(fi);
+        }
+        return results;
+    }, [this, serial](GlobalResults results) {
+        if (serial != m_globalSearchSerial) return; // superseded
+        m_thumbModel->showFiles(std::move(results.items), results.infos);
+        m_filter->setCurrentPage(1);
+    });
+}
+
 void MainWindow::setWorkspaceDirectory(const QString& dir) {
     if (dir.isEmpty()) return;
+    m_currentDir = dir;
+    if (m_globalSearchAction && m_globalSearchAction->isChecked()) {
+        m_globalSearchAction->setChecked(false); // picking a workspace leaves global search
+    }
     m_tabs->setTabText(m_mainTabIndex, QString("Main (%1)").arg(QFileInfo(dir).fileName()));
     m_search->clear();
     m_thumbModel->setDirectory(dir);
-    m_paged->setCurrentPage(1);
+    m_filter->setCurrentPage(1);
 }
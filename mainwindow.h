@@ -2,35 +2,59 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <optional>
 
 #include "taggerstore.h"
 #include "filehasher.h"
+#include "fileitem.h"
 
+class QAction;
+class QTimer;
 class QListView;
 class QTabWidget;
 class QLineEdit;
 class QListView;
 class ThumbnailModel;
 class FilterProxy;
-class PagedProxy;
 class PaginationBar;
+class SidecarImporter;
 class WorkspaceListModel;
-struct FileItem;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
 public:
     explicit MainWindow(QWidget* parent = nullptr);
+    ~MainWindow() override;
 
 private:
+    // What the previous session left in the store, read in the background
+    struct StartupState {
+        std::optional<QString> scrollMode;
+        QList<WorkspaceRec> workspaces;
+        QVector<FileItem> tabs; // open tabs that still exist, without icons
+        QStringList missingTabs;
+    };
+
+    struct GlobalResults {
+        QVector<FileItem> items;
+        QVector<QFileInfo> infos; // row-aligned
+    };
+    static constexpr int kGlobalSearchLimit = 2000; // newest first
+
     void buildUi();
+    void runGlobalSearch();
+    void applyStartupState(const StartupState& state);
     void setWorkspaceDirectory(const QString& dir);
     void addWorkspaceAndSelect(const QString& dir);
-    void restoreOpenTabs();
+    void restoreOpenTabs(const StartupState& state);
     QWidget* createDetailsTab(const FileItem& item);
     bool navigateDetailsTab(QWidget* tab, int direction);
     bool openFileTab(const FileItem& item, bool setCurrent = true, bool persist = true);
-    bool openFileTab(const QString& path, bool setCurrent = true, bool persist = true);
+    // Comma-separated tags from a small dialog, with completion; empty if cancelled
+    QStringList askForTags(const QString& title, const QString& label);
+    void tagSelection(const QStringList& tags, bool add); // add or remove, every selected file
+    // Blocking (stat + store read): for worker threads
+    static std::optional<FileItem> fileItemForTab(const QString& path, TaggerStore* store);
 
     QWidget* buildMainTab();
 
@@ -43,16 +67,21 @@ private:
     QLineEdit* m_search = nullptr;
     QListView* m_thumbView = nullptr;
     PaginationBar* m_pager = nullptr;
+    QAction* m_scrollModeAction = nullptr; // infinite scroll instead of pages
+    QAction* m_globalSearchAction = nullptr; // search the catalog, not the folder
+    QTimer* m_globalSearchTimer = nullptr;
+    int m_globalSearchSerial = 0;            // latest global query; older results are dropped
+    QString m_currentDir;                    // selected workspace
 
     // data
     ThumbnailModel* m_thumbModel = nullptr;
-    FilterProxy* m_filter = nullptr;
-    PagedProxy* m_paged = nullptr;
+    FilterProxy* m_filter = nullptr; // filter + pager
 
     int m_mainTabIndex = 0;
 
     TaggerStore* m_store = nullptr;
     FileHasher* m_hasher = nullptr;
+    SidecarImporter* m_sidecars = nullptr;
 };
 
 #endif // MAINWINDOW_H
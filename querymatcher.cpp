@@ -0,0 +1,682 @@
+#include "querymatcher.h"
+
+#include <QStack>
+#include <algorithm>
+#include <limits>
+
+namespace QueryMatcher {
+
+// ---------- Lexing ----------
+
+enum class LexKind { Word, Number, CmpOp, AndOp, OrOp };
+
+struct LexToken {
+    LexKind kind;
+    QString text;   // for Word/CmpOp
+    qint64 number{}; // for Number
+};
+
+static bool isDelim(QChar c) {
+    return c.isSpace() || c == '&' || c == '|' || c == '<' || c == '>' || c == '=';
+}
+
+static bool isAllDigits(const QString& s) {
+    if (s.isEmpty()) return false;
+    for (QChar c : s) if (!c.isDigit()) return false;
+    return true;
+}
+
+static QVector<LexToken> lex(const QString& input) {
+    QVector<LexToken> out;
+    const QString s = input.trimmed();
+    int i = 0;
+
+    auto peek = [&](int off = 0) -> QChar {
+        const int k = i + off;
+        return (k >= 0 && k < s.size()) ? s[k] : QChar();
+    };
+
+    while (i < s.size()) {
+        const QChar c = s[i];
+
+        if (c.isSpace()) { ++i; continue; }
+
+        if (c == '&') { out.push_back({LexKind::AndOp, "&", 0}); ++i; continue; }
+        if (c == '|') { out.push_back({LexKind::OrOp,  "|", 0}); ++i; continue; }
+
+        // Comparison operators: <= >= == < >
+        if (c == '<' || c == '>' || c == '=') {
+            QString op;
+            op += c;
+            if ((c == '<' || c == '>') && peek(1) == '=') { op += '='; i += 2; }
+            else if (c == '=' && peek(1) == '=') { op = "=="; i += 2; }
+            else { ++i; } // allows single '<' or '>' or (oddly) single '='
+
+            out.push_back({LexKind::CmpOp, op, 0});
+            continue;
+        }
+
+        // Read a "wordish" token until delimiter (allows dots, dashes, unicode, etc.)
+        int start = i;
+        while (i < s.size() && !isDelim(s[i])) ++i;
+        const QString token = s.mid(start, i - start);
+
+        if (isAllDigits(token)) {
+            out.push_back({LexKind::Number, QString(), token.toLongLong()});
+        } else {
+            out.push_back({LexKind::Word, token, 0});
+        }
+    }
+
+    return out;
+}
+
+// ---------- Terms ----------
+
+static int precedence(OpCode op) {
+    // & has higher precedence than |
+    return (op == OpCode::And) ? 2 : 1;
+}
+
+static Term makeUnaryTerm(const QString& rawToken) {
+    Term t;
+    const QString tok = rawToken.trimmed();
+    const QString low = tok.toLower();
+
+    if (low == "picture") { t.kind = TermKind::Picture; return t; }
+    if (low == "video")   { t.kind = TermKind::Video;   return t; }
+
+    // Default unary: filename contains OR tag equals (case-insensitive)
+    t.kind = TermKind::Text;
+    t.text = tok;
+    t.folded = SearchIndex::fold(tok);
+    return t;
+}
+
+static bool parseCmp(const QString& op, CmpOp* out) {
+    if (op == "<")  { *out = CmpOp::Lt; return true; }
+    if (op == "<=") { *out = CmpOp::Le; return true; }
+    if (op == ">")  { *out = CmpOp::Gt; return true; }
+    if (op == ">=") { *out = CmpOp::Ge; return true; }
+    if (op == "==") { *out = CmpOp::Eq; return true; }
+    return false;
+}
+
+static Term makeBinaryTerm(const QString& fieldRaw, const QString& cmpOp, qint64 value) {
+    Term t;
+    const QString field = fieldRaw.toLower();
+
+    // If somebody typed weird stuff (or an unknown field), fail closed: Never.
+    if (!parseCmp(cmpOp, &t.cmp)) return t;
+    t.value = value;
+
+    if (field == "year") t.kind = TermKind::Year;
+    else if (field == "size") t.kind = TermKind::Size;
+    return t;
+}
+
+static bool evalCmp(qint64 left, CmpOp op, qint64 right) {
+    switch (op) {
+    case CmpOp::Lt: return left <  right;
+    case CmpOp::Le: return left <= right;
+    case CmpOp::Gt: return left >  right;
+    case CmpOp::Ge: return left >= right;
+    case CmpOp::Eq: return left == right;
+    }
+    return false;
+}
+
+static bool rowHasTag(const SearchIndex& index, int row, int tagId) {
+    if (tagId < 0) return false;
+    for (const int* p = index.tagIdsBegin(row), *e = index.tagIdsEnd(row); p != e; ++p) {
+        if (*p == tagId) return true;
+    }
+    return false;
+}
+
+static bool evalTerm(const Term& t, int tagId, const SearchIndex& index, int row) {
+    switch (t.kind) {
+    case TermKind::Picture: return index.kind(row) == FileKind::Picture;
+    case TermKind::Video:   return index.kind(row) == FileKind::Video;
+    case TermKind::Text:
+        // both sides are case-folded already
+        return FoldedSearch::contains(index.foldedName(row), t.folded) || rowHasTag(index, row, tagId);
+    case TermKind::Year:
+        return evalCmp(index.year(row), t.cmp, t.value);
+    case TermKind::Size:
+        return evalCmp(index.size(row), t.cmp, t.value);
+    case TermKind::Never:
+        break;
+    }
+    return false;
+}
+
+// ---------- Compilation ----------
+
+// Convert lex tokens -> infix term/operator stream, inserting implicit AND
+static QVector<Instr> toInfix(const QVector<LexToken>& ltoks, QVector<Term>* terms) {
+    QVector<Instr> infix;
+
+    auto pushOp = [&](OpCode op){
+        infix.push_back(Instr{op, -1});
+    };
+    auto pushTerm = [&](Term t){
+        terms->push_back(std::move(t));
+        infix.push_back(Instr{OpCode::Term, int(terms->size()) - 1});
+    };
+    auto isPrevTerm = [&](){
+        return !infix.isEmpty() && infix.back().op == OpCode::Term;
+    };
+
+    for (int i = 0; i < ltoks.size(); ++i) {
+        const LexToken& t = ltoks[i];
+
+        if (t.kind == LexKind::AndOp) { pushOp(OpCode::And); continue; }
+        if (t.kind == LexKind::OrOp)  { pushOp(OpCode::Or);  continue; }
+
+        // Try to build (field cmp number): Word + CmpOp + Number
+        if (t.kind == LexKind::Word
+            && i + 2 < ltoks.size()
+            && ltoks[i + 1].kind == LexKind::CmpOp
+            && ltoks[i + 2].kind == LexKind::Number)
+        {
+            if (isPrevTerm()) pushOp(OpCode::And); // implicit AND: "... <term> year > 2021"
+            pushTerm(makeBinaryTerm(t.text, ltoks[i + 1].text, ltoks[i + 2].number));
+            i += 2;
+            continue;
+        }
+
+        // Unary token: Word or Number (numbers treated like text tokens too)
+        if (t.kind == LexKind::Word) {
+            if (isPrevTerm()) pushOp(OpCode::And); // implicit AND on whitespace adjacency
+            pushTerm(makeUnaryTerm(t.text));
+            continue;
+        }
+
+        if (t.kind == LexKind::Number) {
+            if (isPrevTerm()) pushOp(OpCode::And);
+            pushTerm(makeUnaryTerm(QString::number(t.number)));
+            continue;
+        }
+
+        // Lone comparison operator etc. => ignored (could also make whole query invalid)
+        // We'll just ignore it to avoid exploding on typos.
+    }
+
+    return infix;
+}
+
+// Shunting-yard: infix -> RPN (only binary ops, left-associative)
+static QVector<Instr> toRpn(const QVector<Instr>& infix, bool* okOut) {
+    QVector<Instr> output;
+    QStack<Instr> ops;
+    bool ok = true;
+
+    for (const Instr& t : infix) {
+        if (t.op == OpCode::Term) {
+            output.push_back(t);
+        } else {
+            while (!ops.isEmpty() && precedence(ops.top().op) >= precedence(t.op)) {
+                output.push_back(ops.pop());
+            }
+            ops.push(t);
+        }
+    }
+    while (!ops.isEmpty()) output.push_back(ops.pop());
+
+    // Validate once here so evaluation never has to
+    int stackDepth = 0;
+    for (const Instr& t : output) {
+        if (t.op == OpCode::Term) {
+            ++stackDepth;
+        } else {
+            // binary operator needs 2 operands
+            if (stackDepth < 2) { ok = false; break; }
+            --stackDepth; // consumes 2, produces 1
+        }
+    }
+    if (stackDepth != 1 && !output.isEmpty()) ok = false;
+
+    if (okOut) *okOut = ok;
+    return output;
+}
+
+// Rough work per tested row, in units of one column compare
+static double termCost(const Term& t, bool haveTrigrams) {
+    switch (t.kind) {
+    case TermKind::Never:   return 0.0;
+    case TermKind::Picture:
+    case TermKind::Video:   return 0.02; // bitmap AND
+    case TermKind::Year:
+    case TermKind::Size:    return 1.0;
+    case TermKind::Text:
+        // Name scan; with trigrams only the candidates are scanned
+        return haveTrigrams && t.folded.size() >= TrigramIndex::kMinNeedle ? 3.0 : 10.0;
+    }
+    return 1.0;
+}
+
+// Appends the subtree whose RPN ends at code[*pos] to *nodes, root last. Nested
+// groups of the same operator are absorbed into their parent (and stay behind
+// in *nodes unreferenced).
+static int buildNode(const QVector<Instr>& code, int* pos, QVector<Node>* nodes) {
+    const Instr in = code[(*pos)--];
+    Node n;
+    n.op = in.op;
+    if (in.op == OpCode::Term) {
+        n.term = in.term;
+    } else {
+        // Reading backwards, the right operand comes first
+        const int right = buildNode(code, pos, nodes);
+        const int left = buildNode(code, pos, nodes);
+        for (int child : {left, right}) {
+            const Node& c = nodes->at(child);
+            if (c.op == in.op) n.children += c.children;
+            else n.children.push_back(child);
+        }
+    }
+    nodes->push_back(n);
+    return nodes->size() - 1;
+}
+
+// Default operand order, used per row and whenever no statistics are at hand:
+// cheapest first. Children precede their parents in *nodes.
+static void sortByStaticCost(const QVector<Term>& terms, QVector<Node>* nodes) {
+    QVector<double> cost(nodes->size(), 0.0);
+    for (int i = 0; i < nodes->size(); ++i) {
+        Node& n = (*nodes)[i];
+        if (n.op == OpCode::Term) { cost[i] = termCost(terms[n.term], false); continue; }
+        std::stable_sort(n.children.begin(), n.children.end(),
+                         [&cost](int a, int b) { return cost[a] < cost[b]; });
+        for (int c : n.children) cost[i] += cost[c];
+    }
+}
+
+Plan compile(const QString& query) {
+    Plan plan;
+    const QString q = query.trimmed();
+    if (q.isEmpty()) return plan; // empty query matches all
+
+    bool ok = true;
+    plan.m_code = toRpn(toInfix(lex(q), &plan.m_terms), &ok);
+
+    // If user typed nonsense, do something predictable: match by raw text as a unary token.
+    if (!ok) {
+        plan.m_terms = {makeUnaryTerm(q)};
+        plan.m_code = {Instr{OpCode::Term, 0}};
+    }
+
+    if (!plan.m_code.isEmpty()) {
+        int pos = plan.m_code.size() - 1;
+        buildNode(plan.m_code, &pos, &plan.m_nodes);
+        sortByStaticCost(plan.m_terms, &plan.m_nodes);
+    }
+    return plan;
+}
+
+// ---------- Evaluation ----------
+
+Binding Plan::bind(const SearchIndex& index) const {
+    Binding b;
+    b.generation = index.generation();
+    b.tagIds.reserve(m_terms.size());
+    for (const Term& t : m_terms)
+        b.tagIds.push_back(t.kind == TermKind::Text ? index.tagId(t.folded) : -1);
+    return b;
+}
+
+QString termKey(const Term& t) {
+    switch (t.kind) {
+    case TermKind::Never:   return QStringLiteral("never");
+    case TermKind::Picture: return QStringLiteral("picture");
+    case TermKind::Video:   return QStringLiteral("video");
+    case TermKind::Text:    return QStringLiteral("text:") + t.folded;
+    case TermKind::Year:    return QStringLiteral("year %1 %2").arg(int(t.cmp)).arg(t.value);
+    case TermKind::Size:    return QStringLiteral("size %1 %2").arg(int(t.cmp)).arg(t.value);
+    }
+    return QString();
+}
+
+double Selectivity::estimate(const QString& key, double fallback) const {
+    QMutexLocker lock(&m_lock);
+    return m_rates.value(key, fallback);
+}
+
+void Selectivity::record(const QString& key, int tested, int passed) {
+    if (tested <= 0) return;
+    const double rate = double(passed) / tested;
+
+    QMutexLocker lock(&m_lock);
+    auto it = m_rates.find(key);
+    if (it == m_rates.end()) {
+        if (m_rates.size() >= 512) m_rates.clear(); // old queries; start over
+        m_rates.insert(key, rate);
+    } else {
+        *it = 0.7 * *it + 0.3 * rate;
+    }
+}
+
+struct EvalContext {
+    const SearchIndex& index;
+    const std::atomic<bool>* cancel;  // null = never cancelled
+
+    bool cancelled() const { return cancel && cancel->load(std::memory_order_relaxed); }
+};
+
+// Rows of `domain` (all rows if null) that satisfy pred
+template <typename Pred>
+static RowBitmap scanRows(const EvalContext& cx, const RowBitmap* domain, Pred&& pred) {
+    RowBitmap out;
+    if (domain) {
+        int seen = 0;
+        bool stop = false;
+        domain->forEach([&](int row) {
+            if (stop) return;
+            if ((++seen & 4095) == 0 && cx.cancelled()) { stop = true; return; }
+            if (pred(row)) out.add(row);
+        });
+        return out;
+    }
+    const int n = cx.index.rowCount();
+    for (int row = 0; row < n; ++row) {
+        if ((row & 4095) == 0 && cx.cancelled()) break;
+        if (pred(row)) out.add(row);
+    }
+    return out;
+}
+
+static RowBitmap within(const RowBitmap& rows, const RowBitmap* domain) {
+    return domain ? rows & *domain : rows;
+}
+
+// Rows in [begin, end) whose name contains needle, found by searching the pooled
+// name buffer: one SIMD search spans many short names, and a hit is mapped back
+// to its row (a hit straddling two names is no match).
+static RowBitmap scanNamesPooled(const EvalContext& cx, QStringView needle, int begin, int end) {
+    if (needle.isEmpty()) return RowBitmap::range(begin, end);
+
+    const SearchIndex& index = cx.index;
+    const QStringView names = index.names();
+    const qsizetype m = needle.size();
+    const qsizetype stop = index.nameOffset(end);
+    qsizetype pos = index.nameOffset(begin);
+    int row = begin;
+    int probes = 0;
+
+    RowBitmap out;
+    while (row < end && pos + m <= stop) {
+        if ((++probes & 1023) == 0 && cx.cancelled()) break;
+        const qsizetype hit = FoldedSearch::indexOf(names.mid(pos, stop - pos), needle);
+        if (hit < 0) break;
+        const qsizetype at = pos + hit;
+        while (index.nameOffset(row + 1) <= at) ++row;
+        if (at + m <= index.nameOffset(row + 1)) {
+            out.add(row);
+            pos = index.nameOffset(++row); // rest of this name is irrelevant
+        } else {
+            pos = at + 1;
+        }
+    }
+    return out;
+}
+
+// Rows of `candidates` (all rows if null) whose name contains needle
+static RowBitmap scanNames(const EvalContext& cx, const QString& needle, const RowBitmap* candidates) {
+    if (!candidates) return scanNamesPooled(cx, needle, 0, cx.index.rowCount());
+
+    // Dense enough: search the candidates' whole span in one go and drop the rest
+    const int first = candidates->first();
+    if (first < 0) return {};
+    const int span = candidates->last() - first + 1;
+    if (candidates->cardinality() * 4 >= span)
+        return scanNamesPooled(cx, needle, first, first + span) & *candidates;
+
+    const SearchIndex& index = cx.index;
+    return scanRows(cx, candidates, [&](int row) {
+        return FoldedSearch::contains(index.foldedName(row), needle);
+    });
+}
+
+static RowBitmap evalTermRows(const Term& t, int tagId, const EvalContext& cx, const RowBitmap* domain) {
+    const SearchIndex& index = cx.index;
+    switch (t.kind) {
+    case TermKind::Picture: return within(index.rowsOfKind(FileKind::Picture), domain);
+    case TermKind::Video:   return within(index.rowsOfKind(FileKind::Video), domain);
+    case TermKind::Text: {
+        RowBitmap named;
+        const TrigramIndex* trigrams = index.trigrams();
+        if (trigrams && t.folded.size() >= TrigramIndex::kMinNeedle) {
+            // Trigram hits are a superset: a name can hold every trigram of the needle but not the needle
+            const RowBitmap candidates = within(trigrams->candidates(t.folded), domain);
+            named = scanNames(cx, t.folded, &candidates);
+        } else {
+            named = scanNames(cx, t.folded, domain);
+        }
+        return within(index.rowsWithTag(tagId), domain) | named;
+    }
+    case TermKind::Year:
+        return scanRows(cx, domain, [&](int row) { return evalCmp(index.year(row), t.cmp, t.value); });
+    case TermKind::Size:
+        return scanRows(cx, domain, [&](int row) { return evalCmp(index.size(row), t.cmp, t.value); });
+    case TermKind::Never:
+        break;
+    }
+    return {};
+}
+
+// ---------- Planning ----------
+
+// Per node: expected work for one input row, and the fraction of rows it keeps
+struct Estimate {
+    double cost = 0.0;
+    double selectivity = 1.0;
+};
+
+struct Planner {
+    const QVector<Term>& terms;
+    const QVector<Node>& nodes;
+    const SearchIndex& index;
+    const Binding& binding;
+    Selectivity* stats;
+    QVector<QVector<int>> order; // per group node, operands in evaluation order
+};
+
+static double defaultSelectivity(const Term& t, const SearchIndex& index) {
+    const int rows = qMax(1, index.rowCount());
+    switch (t.kind) {
+    case TermKind::Never:   return 0.0;
+    case TermKind::Picture: return double(index.rowsOfKind(FileKind::Picture).cardinality()) / rows;
+    case TermKind::Video:   return double(index.rowsOfKind(FileKind::Video).cardinality()) / rows;
+    case TermKind::Year:
+    case TermKind::Size:    return t.cmp == CmpOp::Eq ? 0.05 : 0.5;
+    case TermKind::Text:    return 0.05;
+    }
+    return 0.5;
+}
+
+static Estimate planNode(Planner& p, int node) {
+    const Node& n = p.nodes[node];
+    if (n.op == OpCode::Term) {
+        const Term& t = p.terms[n.term];
+        Estimate e;
+        e.cost = termCost(t, p.index.trigrams() != nullptr);
+        e.selectivity = defaultSelectivity(t, p.index);
+        if (p.stats) e.selectivity = p.stats->estimate(termKey(t), e.selectivity);
+        return e;
+    }
+
+    QVector<Estimate> est(p.nodes.size());
+    for (int c : n.children) est[c] = planNode(p, c);
+
+    // Classic rank ordering: an AND operand pays off by the rows it drops,
+    // an OR operand by the rows it settles.
+    const bool isAnd = n.op == OpCode::And;
+    auto rank = [&](int c) {
+        const double settled = isAnd ? 1.0 - est[c].selectivity : est[c].selectivity;
+        return settled > 0.0 ? est[c].cost / settled : std::numeric_limits<double>::infinity();
+    };
+    QVector<int> ordered = n.children;
+    std::stable_sort(ordered.begin(), ordered.end(), [&](int a, int b) { return rank(a) < rank(b); });
+
+    Estimate e;
+    double reach = 1.0; // fraction of input rows still undecided when an operand runs
+    for (int c : ordered) {
+        e.cost += reach * est[c].cost;
+        reach *= isAnd ? est[c].selectivity : 1.0 - est[c].selectivity;
+    }
+    e.selectivity = isAnd ? reach : 1.0 - reach;
+
+    p.order[node] = std::move(ordered);
+    return e;
+}
+
+// ---------- Evaluation ----------
+
+static RowBitmap evalNode(const Planner& p, const EvalContext& cx, int node, const RowBitmap* domain) {
+    const Node& n = p.nodes[node];
+
+    if (n.op == OpCode::Term) {
+        RowBitmap hits = evalTermRows(p.terms[n.term], p.binding.tagIds[n.term], cx, domain);
+        if (p.stats && !cx.cancelled()) {
+            const int tested = domain ? domain->cardinality() : cx.index.rowCount();
+            if (tested >= 64) p.stats->record(termKey(p.terms[n.term]), tested, hits.cardinality());
+        }
+        return hits;
+    }
+
+    const QVector<int>& ordered = p.order[node];
+
+    // AND: each operand only sees the rows all earlier ones kept
+    if (n.op == OpCode::And) {
+        RowBitmap kept;
+        const RowBitmap* in = domain;
+        for (int c : ordered) {
+            kept = evalNode(p, cx, c, in);
+            in = &kept;
+            if (kept.isEmpty() || cx.cancelled()) break;
+        }
+        return kept;
+    }
+
+    // OR: each operand only sees the rows no earlier one matched
+    RowBitmap matched;
+    RowBitmap open;
+    const RowBitmap* in = domain;
+    for (int i = 0; i < ordered.size(); ++i) {
+        const RowBitmap hits = evalNode(p, cx, ordered[i], in);
+        matched |= hits;
+        if (i + 1 == ordered.size() || cx.cancelled()) break;
+        open = in ? in->andNot(hits) : RowBitmap::range(0, cx.index.rowCount()).andNot(hits);
+        in = &open;
+        if (open.isEmpty()) break;
+    }
+    return matched;
+}
+
+RowBitmap Plan::evaluate(const SearchIndex& index, const Binding& binding, const RowBitmap* domain,
+                         const std::atomic<bool>* cancel, Selectivity* stats) const {
+    if (m_nodes.isEmpty()) return domain ? *domain : RowBitmap::range(0, index.rowCount());
+
+    const EvalContext cx{index, cancel};
+    Planner planner{m_terms, m_nodes, index, binding, stats, QVector<QVector<int>>(m_nodes.size())};
+    const int root = m_nodes.size() - 1;
+    planNode(planner, root);
+    return evalNode(planner, cx, root, domain);
+}
+
+// ---------- Refinement ----------
+
+static bool isConjunction(const QVector<Instr>& code) {
+    for (const Instr& in : code) {
+        if (in.op == OpCode::Or) return false;
+    }
+    return true;
+}
+
+// Does `now` imply `before`, except for rows that carry `now`'s tag (see *widened)?
+static bool termRefines(const Term& now, const Term& before, bool* widened) {
+    *widened = false;
+    if (now.kind != before.kind) return false;
+    switch (now.kind) {
+    case TermKind::Picture:
+    case TermKind::Video:
+    case TermKind::Never:
+        return true;
+    case TermKind::Text:
+        if (now.folded == before.folded) return true;
+        // "cat" -> "cats": name hits still contain "cat", but a row tagged exactly
+        // "cats" matches now without having matched before.
+        if (now.folded.contains(before.folded)) { *widened = true; return true; }
+        return false;
+    case TermKind::Year:
+    case TermKind::Size:
+        if (now.cmp != before.cmp) return false;
+        switch (now.cmp) {
+        case CmpOp::Gt: case CmpOp::Ge: return now.value >= before.value;
+        case CmpOp::Lt: case CmpOp::Le: return now.value <= before.value;
+        case CmpOp::Eq: return now.value == before.value;
+        }
+    }
+    return false;
+}
+
+bool Plan::refines(const Plan& previous, QVector<int>* widenedTerms) const {
+    widenedTerms->clear();
+    if (previous.isEmpty() || isEmpty()) return false;
+    if (!isConjunction(m_code) || !isConjunction(previous.m_code)) return false;
+
+    // Terms of a conjunction appear in typing order; walk both in step, letting the
+    // new query insert extra terms (more ANDs only narrow the result).
+    int j = 0;
+    for (const Term& before : previous.m_terms) {
+        bool matched = false;
+        for (; j < m_terms.size() && !matched; ++j) {
+            bool widened = false;
+            if (termRefines(m_terms[j], before, &widened)) {
+                matched = true;
+                if (widened) widenedTerms->push_back(j);
+            }
+        }
+        if (!matched) return false;
+    }
+    return true;
+}
+
+quint8 Plan::fields() const {
+    quint8 f = NoField;
+    for (const Term& t : m_terms) {
+        switch (t.kind) {
+        case TermKind::Never:   break;
+        case TermKind::Picture:
+        case TermKind::Video:   f |= KindField; break;
+        case TermKind::Text:    f |= NameField | TagsField; break;
+        case TermKind::Year:    f |= YearField; break;
+        case TermKind::Size:    f |= SizeField; break;
+        }
+    }
+    return f;
+}
+
+bool Plan::matchesNode(const SearchIndex& index, const Binding& binding, int node, int row) const {
+    const Node& n = m_nodes[node];
+    switch (n.op) {
+    case OpCode::Term:
+        return evalTerm(m_terms[n.term], binding.tagIds[n.term], index, row);
+    case OpCode::And:
+        for (int c : n.children)
+            if (!matchesNode(index, binding, c, row)) return false;
+        return true;
+    case OpCode::Or:
+        for (int c : n.children)
+            if (matchesNode(index, binding, c, row)) return true;
+        return false;
+    }
+    return false;
+}
+
+bool Plan::matches(const SearchIndex& index, const Binding& binding, int row) const {
+    if (m_nodes.isEmpty()) return true;
+    return matchesNode(index, binding, m_nodes.size() - 1, row);
+}
+
+} // namespace QueryMatcher
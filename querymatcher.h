@@ -0,0 +1,134 @@
+#ifndef QUERYMATCHER_H
+#define QUERYMATCHER_H
+
+#pragma once
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include "fileitem.h"
+#include "searchindex.h"
+
+// Search box query language:
+//   term term        implicit AND
+//   a & b, a | b     & binds tighter than |
+//   picture, video   file kind
+//   year > 2021      also <, <=, >=, ==; "size" compares bytes
+//   anything else    file name contains OR a tag equals (case-insensitive)
+namespace QueryMatcher {
+
+enum class TermKind : quint8 { Never, Picture, Video, Text, Year, Size };
+enum class CmpOp : quint8 { Lt, Le, Gt, Ge, Eq };
+
+struct Term {
+    TermKind kind = TermKind::Never;
+    CmpOp cmp = CmpOp::Eq;
+    qint64 value = 0;
+    QString text;   // TermKind::Text only, as typed
+    QString folded; // SearchIndex::fold(text)
+};
+
+// Row fields a query can read; lets callers skip re-evaluation on unrelated changes
+enum Field : quint8 {
+    NoField   = 0,
+    NameField = 1 << 0,
+    TagsField = 1 << 1,
+    KindField = 1 << 2,
+    YearField = 1 << 3,
+    SizeField = 1 << 4,
+};
+
+enum class OpCode : quint8 { Term, And, Or };
+
+struct Instr {
+    OpCode op = OpCode::Term;
+    int term = -1; // index into Plan::terms for OpCode::Term
+};
+
+// Operator tree built from the RPN: runs of the same operator become one n-ary
+// group, e.g. "a b c | d" is Or(And(a, b, c), d).
+struct Node {
+    OpCode op = OpCode::Term;
+    int term = -1;          // OpCode::Term
+    QVector<int> children;  // And/Or, indexes into Plan's nodes, cheapest first
+};
+
+// Observed pass rates of terms across evaluations, keyed by term (kind, operator,
+// value), used to order the operands of AND/OR groups. Thread-safe: one instance
+// serves all evaluations of a filter, including parallel slices.
+class Selectivity {
+public:
+    double estimate(const QString& key, double fallback) const;
+    void record(const QString& key, int tested, int passed);
+
+private:
+    mutable QMutex m_lock;
+    QHash<QString, double> m_rates; // smoothed fraction of tested rows that passed
+};
+
+// Resolution of a plan against one SearchIndex (tag ids of text terms).
+// Stale once the index generation moves on; rebind then.
+struct Binding {
+    quint64 generation = 0;
+    QVector<int> tagIds; // per term, -1 = tag not present in the index
+};
+
+// Immutable, pre-validated query. Build with compile(), then evaluate it
+// set-at-a-time over a whole index or per row; both short-circuit.
+class Plan {
+public:
+    bool isEmpty() const { return m_code.isEmpty(); }
+
+    Binding bind(const SearchIndex& index) const;
+
+    // All matching rows, or only those within `domain` when given. Tag and kind
+    // terms come straight from the index's bitmaps; name/year/size terms scan
+    // columns. An AND group feeds each operand only the rows its predecessors
+    // kept, an OR group only the rows not yet matched, and both stop once nothing
+    // is left to decide. Operands run in order of expected cost per row eliminated,
+    // from `stats` when given (and fed back into it) or static estimates otherwise.
+    // Safe to call from worker threads on a SearchIndex copy; returns early
+    // (garbage) once *cancel turns true.
+    RowBitmap evaluate(const SearchIndex& index, const Binding& binding,
+                       const RowBitmap* domain = nullptr,
+                       const std::atomic<bool>* cancel = nullptr,
+                       Selectivity* stats = nullptr) const;
+
+    // True if every row matching this plan also matched `previous`, except rows
+    // tagged with one of *widenedTerms (indexes into terms(); a text term that
+    // grew, e.g. "cat" -> "cats", can newly match the tag "cats"). Conservative:
+    // only AND-only queries whose terms were extended or appended qualify.
+    bool refines(const Plan& previous, QVector<int>* widenedTerms) const;
+
+    // One row: a recursive walk of the operator tree, short-circuiting like
+    // evaluate(). No value stack and no allocation; depth is that of the tree.
+    bool matches(const SearchIndex& index, const Binding& binding, int row) const;
+
+    // Field bits read by any term
+    quint8 fields() const;
+
+    const QVector<Term>& terms() const { return m_terms; }
+    const QVector<Instr>& code() const { return m_code; }
+    const QVector<Node>& nodes() const { return m_nodes; } // root last
+
+private:
+    friend Plan compile(const QString& query);
+
+    bool matchesNode(const SearchIndex& index, const Binding& binding, int node, int row) const;
+
+    QVector<Term> m_terms;
+    QVector<Instr> m_code;
+    QVector<Node> m_nodes;
+};
+
+// Stable key of a term for Selectivity
+QString termKey(const Term& term);
+
+// Lexes and compiles once. Malformed queries fall back to a single text term
+// over the whole (trimmed) input, so typing never yields an empty result by accident.
+Plan compile(const QString& query);
+
+} // namespace QueryMatcher
+
+#endif // QUERYMATCHER_H
@@ -0,0 +1,331 @@
+#include "rowbitmap.h"
+
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+int RowBitmap::countTrailingZeros(quint64 v) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward64(&idx, v);
+    return int(idx);
+#else
+    return __builtin_ctzll(v);
+#endif
+}
+
+static int popcount64(quint64 v) {
+#if defined(_MSC_VER)
+    return int(__popcnt64(v));
+#else
+    return __builtin_popcountll(v);
+#endif
+}
+
+static int highestBit64(quint64 v) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanReverse64(&idx, v);
+    return int(idx);
+#else
+    return 63 - __builtin_clzll(v);
+#endif
+}
+
+// ---------- Chunk ----------
+
+bool RowBitmap::Chunk::contains(quint16 low) const {
+    if (isBitset()) return (bits[low >> 6] >> (low & 63)) & 1;
+    return std::binary_search(array.begin(), array.end(), low);
+}
+
+void RowBitmap::Chunk::add(quint16 low) {
+    if (isBitset()) {
+        quint64& w = bits[low >> 6];
+        const quint64 m = quint64(1) << (low & 63);
+        if (!(w & m)) { w |= m; ++card; }
+        return;
+    }
+    // Fast path for the common case of rows appended in order
+    if (array.empty() || array.back() < low) {
+        array.push_back(low);
+    } else {
+        auto it = std::lower_bound(array.begin(), array.end(), low);
+        if (*it == low) return;
+        array.insert(it, low);
+    }
+    if (++card > kArrayMax) toBitset();
+}
+
+void RowBitmap::Chunk::remove(quint16 low) {
+    if (isBitset()) {
+        quint64& w = bits[low >> 6];
+        const quint64 m = quint64(1) << (low & 63);
+        if (w & m) { w &= ~m; --card; }
+        toArrayIfSparse();
+        return;
+    }
+    auto it = std::lower_bound(array.begin(), array.end(), low);
+    if (it == array.end() || *it != low) return;
+    array.erase(it);
+    --card;
+}
+
+void RowBitmap::Chunk::toBitset() {
+    bits.resize(kWords);
+    std::fill(bits.begin(), bits.end(), quint64(0));
+    for (quint16 low : array) bits[low >> 6] |= quint64(1) << (low & 63);
+    array.clear();
+    array.shrink_to_fit();
+}
+
+void RowBitmap::Chunk::toArrayIfSparse() {
+    if (!isBitset() || card > kArrayMax) return;
+    array.clear();
+    array.reserve(card);
+    for (int w = 0; w < kWords; ++w) {
+        quint64 word = bits[w];
+        while (word) {
+            array.push_back(quint16(w * 64 + countTrailingZeros(word)));
+            word &= word - 1;
+        }
+    }
+    bits.clear();
+    bits.shrink_to_fit();
+}
+
+RowBitmap::Chunk RowBitmap::andChunks(const Chunk& a, const Chunk& b) {
+    Chunk out;
+    out.key = a.key;
+    if (a.isBitset() && b.isBitset()) {
+        out.bits.resize(kWords);
+        for (int w = 0; w < kWords; ++w) {
+            out.bits[w] = a.bits[w] & b.bits[w];
+            out.card += popcount64(out.bits[w]);
+        }
+        out.toArrayIfSparse();
+        return out;
+    }
+    if (a.isBitset() || b.isBitset()) {
+        const Chunk& arr = a.isBitset() ? b : a;
+        const Chunk& set = a.isBitset() ? a : b;
+        out.array.reserve(arr.card);
+        for (quint16 low : arr.array)
+            if (set.contains(low)) out.array.push_back(low);
+        out.card = int(out.array.size());
+        return out;
+    }
+    out.array.reserve(qMin(a.card, b.card));
+    std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                          std::back_inserter(out.array));
+    out.card = int(out.array.size());
+    return out;
+}
+
+RowBitmap::Chunk RowBitmap::orChunks(const Chunk& a, const Chunk& b) {
+    Chunk out;
+    out.key = a.key;
+    if (!a.isBitset() && !b.isBitset() && a.card + b.card <= kArrayMax) {
+        out.array.reserve(a.card + b.card);
+        std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                       std::back_inserter(out.array));
+        out.card = int(out.array.size());
+        return out;
+    }
+    out.bits.resize(kWords);
+    std::fill(out.bits.begin(), out.bits.end(), quint64(0));
+    for (const Chunk* c : {&a, &b}) {
+        if (c->isBitset()) {
+            for (int w = 0; w < kWords; ++w) out.bits[w] |= c->bits[w];
+        } else {
+            for (quint16 low : c->array) out.bits[low >> 6] |= quint64(1) << (low & 63);
+        }
+    }
+    for (int w = 0; w < kWords; ++w) out.card += popcount64(out.bits[w]);
+    out.toArrayIfSparse();
+    return out;
+}
+
+RowBitmap::Chunk RowBitmap::andNotChunks(const Chunk& a, const Chunk& b) {
+    Chunk out;
+    out.key = a.key;
+    if (a.isBitset()) {
+        out.bits = a.bits;
+        if (b.isBitset()) {
+            for (int w = 0; w < kWords; ++w) out.bits[w] &= ~b.bits[w];
+        } else {
+            for (quint16 low : b.array) out.bits[low >> 6] &= ~(quint64(1) << (low & 63));
+        }
+        for (int w = 0; w < kWords; ++w) out.card += popcount64(out.bits[w]);
+        out.toArrayIfSparse();
+        return out;
+    }
+    out.array.reserve(a.card);
+    if (b.isBitset()) {
+        for (quint16 low : a.array)
+            if (!b.contains(low)) out.array.push_back(low);
+    } else {
+        std::set_difference(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                            std::back_inserter(out.array));
+    }
+    out.card = int(out.array.size());
+    return out;
+}
+
+// ---------- RowBitmap ----------
+
+RowBitmap RowBitmap::range(int begin, int end) {
+    RowBitmap out;
+    if (begin < 0) begin = 0;
+    while (begin < end) {
+        const quint16 key = quint16(begin >> 16);
+        const int chunkEnd = qMin(end, (int(key) + 1) << 16);
+        Chunk c;
+        c.key = key;
+        c.card = chunkEnd - begin;
+        if (c.card > kArrayMax) {
+            c.bits.resize(kWords);
+            std::fill(c.bits.begin(), c.bits.end(), quint64(0));
+            for (int r = begin; r < chunkEnd; ++r) {
+                const int low = r & 0xffff;
+                c.bits[low >> 6] |= quint64(1) << (low & 63);
+            }
+        } else {
+            c.array.reserve(c.card);
+            for (int r = begin; r < chunkEnd; ++r) c.array.push_back(quint16(r & 0xffff));
+        }
+        out.m_chunks.push_back(std::move(c));
+        begin = chunkEnd;
+    }
+    return out;
+}
+
+int RowBitmap::findChunk(quint16 key) const {
+    // Usually few chunks (one per 64K rows); appends hit the last one
+    if (!m_chunks.empty() && m_chunks.back().key == key) return int(m_chunks.size()) - 1;
+    auto it = std::lower_bound(m_chunks.begin(), m_chunks.end(), key,
+                               [](const Chunk& c, quint16 k) { return c.key < k; });
+    const int pos = int(it - m_chunks.begin());
+    if (it != m_chunks.end() && it->key == key) return pos;
+    return -(pos + 1);
+}
+
+int RowBitmap::cardinality() const {
+    int n = 0;
+    for (const Chunk& c : m_chunks) n += c.card;
+    return n;
+}
+
+bool RowBitmap::contains(int row) const {
+    if (row < 0) return false;
+    const int i = findChunk(quint16(row >> 16));
+    return i >= 0 && m_chunks[i].contains(quint16(row & 0xffff));
+}
+
+int RowBitmap::first() const {
+    if (m_chunks.empty()) return -1;
+    const Chunk& c = m_chunks.front();
+    const int base = int(c.key) << 16;
+    if (!c.isBitset()) return base + c.array.front();
+    for (int w = 0; w < kWords; ++w)
+        if (c.bits[w]) return base + w * 64 + countTrailingZeros(c.bits[w]);
+    return -1;
+}
+
+int RowBitmap::last() const {
+    if (m_chunks.empty()) return -1;
+    const Chunk& c = m_chunks.back();
+    const int base = int(c.key) << 16;
+    if (!c.isBitset()) return base + c.array.back();
+    for (int w = kWords - 1; w >= 0; --w)
+        if (c.bits[w]) return base + w * 64 + highestBit64(c.bits[w]);
+    return -1;
+}
+
+void RowBitmap::add(int row) {
+    if (row < 0) return;
+    const quint16 key = quint16(row >> 16);
+    int i = findChunk(key);
+    if (i < 0) {
+        i = -i - 1;
+        Chunk c;
+        c.key = key;
+        m_chunks.insert(m_chunks.begin() + i, std::move(c));
+    }
+    m_chunks[i].add(quint16(row & 0xffff));
+}
+
+void RowBitmap::remove(int row) {
+    if (row < 0) return;
+    const int i = findChunk(quint16(row >> 16));
+    if (i < 0) return;
+    m_chunks[i].remove(quint16(row & 0xffff));
+    if (m_chunks[i].card == 0) m_chunks.erase(m_chunks.begin() + i);
+}
+
+RowBitmap RowBitmap::operator&(const RowBitmap& o) const {
+    RowBitmap out;
+    int i = 0, j = 0;
+    while (i < int(m_chunks.size()) && j < int(o.m_chunks.size())) {
+        const Chunk& a = m_chunks[i];
+        const Chunk& b = o.m_chunks[j];
+        if (a.key < b.key) { ++i; continue; }
+        if (b.key < a.key) { ++j; continue; }
+        Chunk c = andChunks(a, b);
+        if (c.card) out.m_chunks.push_back(std::move(c));
+        ++i; ++j;
+    }
+    return out;
+}
+
+RowBitmap RowBitmap::operator|(const RowBitmap& o) const {
+    RowBitmap out;
+    int i = 0, j = 0;
+    const int n = int(m_chunks.size()), m = int(o.m_chunks.size());
+    while (i < n || j < m) {
+        if (j >= m || (i < n && m_chunks[i].key < o.m_chunks[j].key)) {
+            out.m_chunks.push_back(m_chunks[i++]);
+        } else if (i >= n || o.m_chunks[j].key < m_chunks[i].key) {
+            out.m_chunks.push_back(o.m_chunks[j++]);
+        } else {
+            out.m_chunks.push_back(orChunks(m_chunks[i++], o.m_chunks[j++]));
+        }
+    }
+    return out;
+}
+
+RowBitmap RowBitmap::andNot(const RowBitmap& o) const {
+    RowBitmap out;
+    int j = 0;
+    for (const Chunk& a : m_chunks) {
+        while (j < int(o.m_chunks.size()) && o.m_chunks[j].key < a.key) ++j;
+        if (j >= int(o.m_chunks.size()) || o.m_chunks[j].key != a.key) {
+            out.m_chunks.push_back(a);
+            continue;
+        }
+        Chunk c = andNotChunks(a, o.m_chunks[j]);
+        if (c.card) out.m_chunks.push_back(std::move(c));
+    }
+    return out;
+}
+
+bool RowBitmap::operator==(const RowBitmap& o) const {
+    if (m_chunks.size() != o.m_chunks.size()) return false;
+    for (int i = 0; i < int(m_chunks.size()); ++i) {
+        const Chunk& a = m_chunks[i];
+        const Chunk& b = o.m_chunks[i];
+        if (a.key != b.key || a.card != b.card) return false;
+        // Representation follows cardinality, so equal sets use the same container kind
+        if (a.isBitset() ? a.bits != b.bits : a.array != b.array) return false;
+    }
+    return true;
+}
+
+QVector<int> RowBitmap::toVector() const {
+    QVector<int> out;
+    out.reserve(cardinality());
+    forEach([&out](int row) { out.push_back(row); });
+    return out;
+}
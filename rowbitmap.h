@@ -0,0 +1,82 @@
+#ifndef ROWBITMAP_H
+#define ROWBITMAP_H
+
+#pragma once
+#include <QVector>
+#include <QtGlobal>
+
+// Compressed set of row numbers, roaring style: rows are split into 64K chunks
+// by their high 16 bits; each chunk is a sorted array of low halves while sparse
+// and a plain 65536-bit bitset once it holds more than 4096 rows.
+class RowBitmap {
+public:
+    static RowBitmap range(int begin, int end); // every row in [begin, end)
+
+    bool isEmpty() const { return m_chunks.empty(); }
+    int cardinality() const;
+    bool contains(int row) const;
+    int first() const; // smallest row, -1 if empty
+    int last() const;  // largest row, -1 if empty
+
+    void add(int row);    // O(1) when rows arrive in increasing order
+    void remove(int row);
+    void clear() { m_chunks.clear(); }
+
+    RowBitmap operator&(const RowBitmap& o) const;
+    RowBitmap operator|(const RowBitmap& o) const;
+    RowBitmap andNot(const RowBitmap& o) const;
+    RowBitmap& operator&=(const RowBitmap& o) { return *this = *this & o; }
+    RowBitmap& operator|=(const RowBitmap& o) { return *this = *this | o; }
+    bool operator==(const RowBitmap& o) const;
+    bool operator!=(const RowBitmap& o) const { return !(*this == o); }
+
+    // Rows in increasing order
+    template <typename F>
+    void forEach(F&& f) const {
+        for (const Chunk& c : m_chunks) {
+            const int base = int(c.key) << 16;
+            if (c.isBitset()) {
+                for (int w = 0; w < kWords; ++w) {
+                    quint64 word = c.bits[w];
+                    while (word) {
+                        f(base + w * 64 + countTrailingZeros(word));
+                        word &= word - 1;
+                    }
+                }
+            } else {
+                for (quint16 low : c.array) f(base + low);
+            }
+        }
+    }
+
+    QVector<int> toVector() const;
+
+private:
+    static constexpr int kWords = 1024;        // 65536 bits
+    static constexpr int kArrayMax = 4096;     // above this a bitset is smaller
+
+    struct Chunk {
+        quint16 key = 0;
+        int card = 0;
+        QVector<quint16> array; // sorted, used while !isBitset()
+        QVector<quint64> bits;  // kWords words, or empty
+
+        bool isBitset() const { return !bits.empty(); }
+        bool contains(quint16 low) const;
+        void add(quint16 low);
+        void remove(quint16 low);
+        void toBitset();
+        void toArrayIfSparse();
+    };
+
+    static int countTrailingZeros(quint64 v);
+    int findChunk(quint16 key) const; // index or -(insertPos + 1)
+
+    static Chunk andChunks(const Chunk& a, const Chunk& b);
+    static Chunk orChunks(const Chunk& a, const Chunk& b);
+    static Chunk andNotChunks(const Chunk& a, const Chunk& b);
+
+    QVector<Chunk> m_chunks; // sorted by key, never holds empty chunks
+};
+
+#endif // ROWBITMAP_H
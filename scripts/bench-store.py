@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+# Read benchmark for the tag store's schema and reader connection settings.
+#
+# Builds a synthetic library (1M files in 5000 folders, 0-5 of 2000 tags each)
+# twice: the old tags_by_path JSON table and the normalized tag_records /
+# file_tags / tags tables. Then times, warm, per reader profile:
+#   - path lookup: the tags of one file
+#   - folder load: the tags of one folder's 200 files
+#   - files with a tag (normalized schema only; the JSON table has to scan)
+#
+#   python3 scripts/bench-store.py [--files N] [--dir /tmp/tagger-bench]
+#
+# Profiles are the PRAGMAs a reader connection runs after opening (see
+# kCommonPragmas and kReaderPragmas in storeconnection.cpp); keep "shipped" in
+# sync with them. Figures vary between runs by a few percent: compare the
+# profiles of one run, and run twice before believing a small difference.
+
+import argparse
+import json
+import os
+import random
+import sqlite3
+import time
+
+PROFILES = {
+    "default": [],
+    "shipped": ["PRAGMA temp_store=MEMORY", "PRAGMA query_only=1"],
+    "mmap+cache": ["PRAGMA mmap_size=268435456", "PRAGMA temp_store=MEMORY",
+                   "PRAGMA cache_size=-4096", "PRAGMA query_only=1"],
+}
+
+TAG_LOOKUP = ("SELECT t.name FROM tag_records r LEFT JOIN file_tags f ON f.kind = r.kind AND f.key = r.key "
+              "LEFT JOIN tags t ON t.id = f.tag_id WHERE r.kind = 0 AND r.key = ? ORDER BY f.pos")
+FOLDER_LOAD = ("SELECT r.key, t.name FROM tag_records r LEFT JOIN file_tags f ON f.kind = r.kind AND f.key = r.key "
+               "LEFT JOIN tags t ON t.id = f.tag_id WHERE r.kind = 0 AND r.key >= ? AND r.key < ? "
+               "ORDER BY r.key, f.pos")
+WITH_TAG = ("SELECT f.key FROM tags t JOIN file_tags f ON f.tag_id = t.id "
+            "WHERE t.name = ? COLLATE NOCASE AND f.kind = 0")
+
+
+def library(files):
+    rng = random.Random(1)
+    tags = [f"tag{i}" for i in range(2000)]
+    paths = [f"/home/u/pics/d{i % 5000:04d}/img_{i:07d}.jpg" for i in range(files)]
+    lists = [rng.sample(range(len(tags)), rng.randint(0, 5)) for _ in paths]
+    return tags, paths, lists
+
+
+def build(fn, normalized, tags, paths, lists):
+    for ext in ("", "-wal", "-shm"):
+        if os.path.exists(fn + ext):
+            os.remove(fn + ext)
+    c = sqlite3.connect(fn, isolation_level=None)
+    c.execute("PRAGMA page_size=4096")
+    c.execute("PRAGMA journal_mode=WAL")
+    c.execute("PRAGMA synchronous=NORMAL")
+    c.execute("BEGIN")
+    if normalized:
+        c.execute("CREATE TABLE tags(id INTEGER PRIMARY KEY, name TEXT NOT NULL UNIQUE)")
+        c.execute("CREATE INDEX idx_tags_name_nocase ON tags(name COLLATE NOCASE)")
+        c.execute("CREATE TABLE tag_records(kind INTEGER NOT NULL, key TEXT NOT NULL, "
+                  "updated_at INTEGER NOT NULL, PRIMARY KEY(kind, key)) WITHOUT ROWID")
+        c.execute("CREATE TABLE file_tags(kind INTEGER NOT NULL, key TEXT NOT NULL, tag_id INTEGER NOT NULL, "
+                  "pos INTEGER NOT NULL, PRIMARY KEY(kind, key, tag_id)) WITHOUT ROWID")
+        c.execute("CREATE INDEX idx_file_tags_tag ON file_tags(tag_id, kind)")
+        c.executemany("INSERT INTO tags(id, name) VALUES(?, ?)", enumerate(tags))
+        c.executemany("INSERT INTO tag_records VALUES(0, ?, 0)", ((p,) for p in paths))
+        c.executemany("INSERT INTO file_tags VALUES(0, ?, ?, ?)",
+                      ((p, t, i) for p, l in zip(paths, lists) for i, t in enumerate(l)))
+    else:
+        c.execute("CREATE TABLE tags_by_path(path TEXT PRIMARY KEY, tags_json TEXT NOT NULL, "
+                  "updated_at INTEGER NOT NULL)")
+        c.executemany("INSERT INTO tags_by_path VALUES(?, ?, 0)",
+                      ((p, json.dumps([tags[t] for t in l])) for p, l in zip(paths, lists)))
+    c.execute("COMMIT")
+    c.execute("ANALYZE")
+    c.execute("PRAGMA wal_checkpoint(TRUNCATE)")
+    c.close()
+
+
+def bench(fn, normalized, profile, tags, paths):
+    rng = random.Random(2)
+    c = sqlite3.connect(fn)
+    for pragma in PROFILES[profile]:
+        c.execute(pragma)
+
+    sample = rng.sample(paths, min(100000, len(paths)))
+    for p in sample[:1000]:  # warm up
+        c.execute(TAG_LOOKUP if normalized else "SELECT tags_json FROM tags_by_path WHERE path = ?", (p,)).fetchall()
+    t = time.perf_counter()
+    for p in sample:
+        if normalized:
+            c.execute(TAG_LOOKUP, (p,)).fetchall()
+        else:
+            json.loads(c.execute("SELECT tags_json FROM tags_by_path WHERE path = ?", (p,)).fetchone()[0])
+    lookup_us = (time.perf_counter() - t) / len(sample) * 1e6
+
+    folders = range(0, 5000, 10)
+    t = time.perf_counter()
+    for d in folders:
+        lo = f"/home/u/pics/d{d:04d}/"
+        hi = lo[:-1] + "0"
+        if normalized:
+            c.execute(FOLDER_LOAD, (lo, hi)).fetchall()
+        else:
+            [(p, json.loads(j)) for p, j in
+             c.execute("SELECT path, tags_json FROM tags_by_path WHERE path >= ? AND path < ?", (lo, hi))]
+    folder_ms = (time.perf_counter() - t) / len(folders) * 1e3
+
+    with_tag = ""
+    if normalized:
+        names = rng.sample(tags, 20)
+        t = time.perf_counter()
+        for name in names:
+            c.execute(WITH_TAG, (name,)).fetchall()
+        with_tag = f", files with tag {(time.perf_counter() - t) / len(names) * 1e3:.2f} ms"
+    c.close()
+
+    schema = "normalized" if normalized else "json"
+    print(f"{schema:10} {profile:10}: path lookup {lookup_us:.1f} us, "
+          f"folder load (200 files) {folder_ms:.2f} ms{with_tag}")
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--files", type=int, default=1_000_000)
+    ap.add_argument("--dir", default="/tmp/tagger-bench")
+    args = ap.parse_args()
+    os.makedirs(args.dir, exist_ok=True)
+
+    tags, paths, lists = library(args.files)
+    for normalized in (False, True):
+        fn = os.path.join(args.dir, "normalized.db" if normalized else "json.db")
+        build(fn, normalized, tags, paths, lists)
+        print(f"{os.path.basename(fn)}: {os.path.getsize(fn) / 1e6:.0f} MB")
+        profiles = PROFILES if normalized else ["default"]
+        for _ in range(2):  # interleaved, twice: one pass alone is noise
+            for profile in profiles:
+                bench(fn, normalized, profile, tags, paths)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,23 @@
+# Checks the compiled search filter against the one it replaced and times both
+# (see main.cpp).
+#   qmake && make && ./filter-bench
+
+QT = core gui
+CONFIG += c++17 console release
+CONFIG -= app_bundle
+
+TARGET = filter-bench
+
+SOURCES += main.cpp \
+    ../../foldedsearch.cpp \
+    ../../querymatcher.cpp \
+    ../../rowbitmap.cpp \
+    ../../searchindex.cpp \
+    ../../trigramindex.cpp
+HEADERS += \
+    ../../foldedsearch.h \
+    ../../querymatcher.h \
+    ../../rowbitmap.h \
+    ../../searchindex.h \
+    ../../trigramindex.h
+INCLUDEPATH += ../..
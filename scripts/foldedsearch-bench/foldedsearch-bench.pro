@@ -0,0 +1,15 @@
+# Checks FoldedSearch's kernels against Qt and times them (see main.cpp).
+#   qmake && make && ./foldedsearch-bench
+# Equivalence check only, under ASan/UBSan:
+#   qmake CONFIG+=sanitizer CONFIG+=sanitize_address CONFIG+=sanitize_undefined && make && ./foldedsearch-bench --check
+
+QT = core
+CONFIG += c++17 console release
+CONFIG -= app_bundle
+
+TARGET = foldedsearch-bench
+
+# main.cpp includes ../../foldedsearch.cpp to reach its static kernels
+SOURCES += main.cpp
+HEADERS += ../../foldedsearch.h
+INCLUDEPATH += ../..
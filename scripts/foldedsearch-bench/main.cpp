@@ -0,0 +1,180 @@
+// FoldedSearch against Qt: every kernel must agree with QStringView::indexOf()
+// on random input, and fold() + indexOf() with QString::contains(..,
+// Qt::CaseInsensitive). Then a name search over 1M synthetic file names, the way
+// the filter used to run it (QString::contains per row) and the way it does now
+// (folded names, one kernel, per row or over the pooled buffer).
+//
+//   ./foldedsearch-bench          check, then time
+//   ./foldedsearch-bench --check  check only (sanitizer builds, see the .pro)
+//
+// Exits non-zero on the first mismatch.
+
+#include "../../foldedsearch.cpp" // the kernels are static
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QVector>
+#include <cstdio>
+
+namespace {
+
+struct Kernel {
+    const char* name;
+    FoldedSearch::Kernel find;
+};
+
+QVector<Kernel> kernels() {
+    QVector<Kernel> out{{"scalar", FoldedSearch::findScalar}};
+#ifdef FOLDEDSEARCH_X86
+    out.push_back({"sse2", FoldedSearch::findSse2});
+    if (FoldedSearch::cpuHasAvx2()) out.push_back({"avx2", FoldedSearch::findAvx2});
+#endif
+    return out;
+}
+
+QString randomText(QRandomGenerator& rng, int maxLen, QStringView alphabet) {
+    const int n = int(rng.bounded(maxLen + 1));
+    QString s(n, Qt::Uninitialized);
+    for (int i = 0; i < n; ++i) s[i] = alphabet[int(rng.bounded(alphabet.size()))];
+    return s;
+}
+
+bool check() {
+    static constexpr int kCases = 200000;
+    QRandomGenerator rng(1);
+    const QVector<Kernel> all = kernels();
+
+    // A small alphabet so needles hit often, at every offset and block boundary
+    const QString folded = QStringLiteral("ab\u00e9\u03c9");
+    for (int i = 0; i < kCases; ++i) {
+        const QString h = randomText(rng, 70, folded);
+        const QString nd = randomText(rng, 6, folded);
+        if (nd.isEmpty() || nd.size() > h.size()) continue;
+        const qsizetype expected = QStringView(h).indexOf(QStringView(nd));
+        for (const Kernel& k : all) {
+            const qsizetype got = k.find(QStringView(h).utf16(), h.size(), QStringView(nd).utf16(), nd.size());
+            if (got != expected) {
+                std::printf("FAIL %s: \"%s\" in \"%s\": %lld, Qt says %lld\n", k.name, qPrintable(nd),
+                            qPrintable(h), qlonglong(got), qlonglong(expected));
+                return false;
+            }
+        }
+    }
+
+    // Mixed case, ASCII and not: folding both sides first is case-insensitive search
+    const QString mixed = QStringLiteral("abAB\u00e9\u00c9\u03c9\u03a9");
+    for (int i = 0; i < kCases; ++i) {
+        const QString h = randomText(rng, 40, mixed);
+        const QString nd = randomText(rng, 4, mixed);
+        const QString fh = FoldedSearch::fold(h);
+        if (fh != h.toCaseFolded()) {
+            std::printf("FAIL fold(\"%s\")\n", qPrintable(h));
+            return false;
+        }
+        if (FoldedSearch::contains(fh, FoldedSearch::fold(nd)) != h.contains(nd, Qt::CaseInsensitive)) {
+            std::printf("FAIL contains: \"%s\" in \"%s\"\n", qPrintable(nd), qPrintable(h));
+            return false;
+        }
+    }
+
+    QStringList names;
+    for (const Kernel& k : all) names << k.name;
+    std::printf("ok: %d + %d random cases, kernels %s (dispatching to %s)\n", kCases, kCases,
+                qPrintable(names.join(", ")), FoldedSearch::kernelName());
+    return true;
+}
+
+template <typename F>
+void timeIt(const char* what, const QString& needle, F&& run) {
+    static constexpr int kRuns = 5;
+    long hits = 0;
+    QElapsedTimer t;
+    t.start();
+    for (int r = 0; r < kRuns; ++r) hits = run();
+    std::printf("  %-28s %-12s %8.2f ms  (%ld hits)\n", what, qPrintable(needle),
+                double(t.nsecsElapsed()) / 1e6 / kRuns, hits);
+}
+
+void bench() {
+    static constexpr int kNames = 1000000;
+    QRandomGenerator rng(1);
+    const char* const words[] = {"IMG", "Vacation", "dsc", "Screenshot", "2023", "holiday", "Family", "beach", "_", "-"};
+
+    // As SearchIndex keeps them: the names, and the folded names pooled with offsets
+    QStringList names;
+    names.reserve(kNames);
+    QString pool;
+    QVector<qsizetype> offsets{0};
+    offsets.reserve(kNames + 1);
+    for (int i = 0; i < kNames; ++i) {
+        QString name;
+        for (int k = 2 + int(rng.bounded(3)); k > 0; --k) name += QLatin1String(words[rng.bounded(10)]);
+        name += QLatin1String(".jpg");
+        names << name;
+        pool += FoldedSearch::fold(name);
+        offsets << pool.size();
+    }
+    std::printf("%d names, %lld units pooled\n", kNames, qlonglong(pool.size()));
+
+    for (const QString needle : {QStringLiteral("Beach"), QStringLiteral("zzz"), QStringLiteral("HolidayFam")}) {
+        const QString nd = FoldedSearch::fold(needle);
+
+        timeIt("QString::contains(CaseIns)", needle, [&] {
+            long hits = 0;
+            for (const QString& name : names) hits += name.contains(needle, Qt::CaseInsensitive);
+            return hits;
+        });
+        timeIt("QStringView::indexOf folded", needle, [&] {
+            long hits = 0;
+            for (int i = 0; i < kNames; ++i) {
+                const QStringView name(pool.constData() + offsets[i], offsets[i + 1] - offsets[i]);
+                hits += name.indexOf(nd) >= 0;
+            }
+            return hits;
+        });
+        timeIt("FoldedSearch per row", needle, [&] {
+            long hits = 0;
+            for (int i = 0; i < kNames; ++i) {
+                const QStringView name(pool.constData() + offsets[i], offsets[i + 1] - offsets[i]);
+                hits += FoldedSearch::contains(name, nd);
+            }
+            return hits;
+        });
+
+        // One pass over the pool; a hit straddling two names is retried one unit on
+        for (const Kernel& k : kernels()) {
+            const QByteArray label = QByteArray("pooled ") + k.name;
+            timeIt(label.constData(), needle, [&] {
+                long hits = 0;
+                qsizetype pos = 0;
+                int row = 0;
+                const qsizetype n = pool.size(), m = nd.size();
+                while (pos + m <= n) {
+                    qsizetype at = k.find(QStringView(pool).utf16() + pos, n - pos, QStringView(nd).utf16(), m);
+                    if (at < 0) break;
+                    at += pos;
+                    while (offsets[row + 1] <= at) ++row;
+                    if (at + m <= offsets[row + 1]) {
+                        ++hits;
+                        pos = offsets[++row];
+                        if (row == kNames) break;
+                    } else {
+                        pos = at + 1;
+                    }
+                }
+                return hits;
+            });
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    QCoreApplication app(argc, argv);
+    if (!check()) return 1;
+    if (!app.arguments().contains(QLatin1String("--check"))) bench();
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include "searchindex.h"
+
+#include <algorithm>
+#include <atomic>
+
+static quint64 nextGeneration() {
+    static std::atomic<quint64> counter{0};
+    return ++counter;
+}
+
+void SearchIndex::touch() {
+    m_generation = nextGeneration();
+}
+
+void SearchIndex::clear() {
+    m_names.clear();
+    m_nameOffsets = {0};
+    m_tagIds.clear();
+    m_tagOffsets = {0};
+    m_years.clear();
+    m_sizes.clear();
+    m_kinds.clear();
+    m_tagIdByName.clear();
+    m_tagNames.clear();
+    m_rowsByTag.clear();
+    for (RowBitmap& b : m_rowsByKind) b.clear();
+    m_trigrams.reset();
+    touch();
+}
+
+void SearchIndex::reserve(int rows) {
+    m_names.reserve(rows * 24);
+    m_nameOffsets.reserve(rows + 1);
+    m_tagOffsets.reserve(rows + 1);
+    m_years.reserve(rows);
+    m_sizes.reserve(rows);
+    m_kinds.reserve(rows);
+}
+
+int SearchIndex::internTag(const QString& foldedTag) {
+    auto it = m_tagIdByName.constFind(foldedTag);
+    if (it != m_tagIdByName.constEnd()) return it.value();
+    const int id = m_tagNames.size();
+    m_tagNames.push_back(foldedTag);
+    m_tagIdByName.insert(foldedTag, id);
+    m_rowsByTag.push_back(RowBitmap());
+    return id;
+}
+
+const RowBitmap& SearchIndex::rowsWithTag(int tagId) const {
+    static const RowBitmap empty;
+    if (tagId < 0 || tagId >= m_rowsByTag.size()) return empty;
+    return m_rowsByTag[tagId];
+}
+
+void SearchIndex::setTrigrams(std::shared_ptr<const TrigramIndex> trigrams) {
+    if (trigrams && trigrams->rowCount() != rowCount()) return;
+    m_trigrams = std::move(trigrams);
+}
+
+void SearchIndex::append(const FileItem& item) {
+    const int row = rowCount();
+    m_trigrams.reset(); // new name, not covered
+
+    m_names += fold(item.fileName);
+    m_nameOffsets.push_back(m_names.size());
+
+    for (const QString& t : item.tags) {
+        const int id = internTag(fold(t));
+        // Tags are deduplicated case-sensitively by the editors; fold duplicates here.
+        if (std::find(m_tagIds.cbegin() + m_tagOffsets.last(), m_tagIds.cend(), id) != m_tagIds.cend())
+            continue;
+        m_tagIds.push_back(id);
+        m_rowsByTag[id].add(row);
+    }
+    m_tagOffsets.push_back(m_tagIds.size());
+
+    m_years.push_back(item.modified.isValid() ? item.modified.date().year() : 0);
+    m_sizes.push_back(item.sizeBytes);
+    m_kinds.push_back(quint8(item.kind));
+    m_rowsByKind[int(item.kind)].add(row);
+    touch();
+}
+
+void SearchIndex::setTags(int row, const QStringList& tags) {
+    if (row < 0 || row >= rowCount()) return;
+
+    const int begin = m_tagOffsets[row];
+    const int end = m_tagOffsets[row + 1];
+    for (int i = begin; i < end; ++i) m_rowsByTag[m_tagIds[i]].remove(row);
+
+    QVector<int> ids;
+    for (const QString& t : tags) {
+        const int id = internTag(fold(t));
+        if (ids.contains(id)) continue;
+        ids.push_back(id);
+        m_rowsByTag[id].add(row);
+    }
+
+    // Splice the row's slice of the flat id array and shift later offsets
+    m_tagIds.remove(begin, end - begin);
+    if (!ids.isEmpty()) {
+        m_tagIds.insert(begin, ids.size(), 0);
+        std::copy(ids.cbegin(), ids.cend(), m_tagIds.begin() + begin);
+    }
+    const int delta = ids.size() - (end - begin);
+    if (delta) {
+        for (int r = row + 1; r < m_tagOffsets.size(); ++r) m_tagOffsets[r] += delta;
+    }
+    touch();
+}
+
+void SearchIndex::setTags(const QHash<int, QStringList>& tagsByRow) {
+    if (tagsByRow.isEmpty()) return;
+
+    // Rebuild the flat id array: untouched rows copy their slice, changed ones
+    // intern their new tags
+    QVector<int> ids;
+    ids.reserve(m_tagIds.size());
+    QVector<int> offsets;
+    offsets.reserve(m_tagOffsets.size());
+    offsets.push_back(0);
+    for (int row = 0; row < rowCount(); ++row) {
+        const int begin = m_tagOffsets[row];
+        const int end = m_tagOffsets[row + 1];
+        const auto changed = tagsByRow.constFind(row);
+        if (changed == tagsByRow.constEnd()) {
+            for (int i = begin; i < end; ++i) ids.push_back(m_tagIds[i]);
+        } else {
+            for (int i = begin; i < end; ++i) m_rowsByTag[m_tagIds[i]].remove(row);
+            const int first = ids.size();
+            for (const QString& t : changed.value()) {
+                const int id = internTag(fold(t));
+                if (std::find(ids.cbegin() + first, ids.cend(), id) != ids.cend()) continue;
+                ids.push_back(id);
+                m_rowsByTag[id].add(row);
+            }
+        }
+        offsets.push_back(ids.size());
+    }
+    m_tagIds = std::move(ids);
+    m_tagOffsets = std::move(offsets);
+    touch();
+}
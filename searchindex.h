@@ -0,0 +1,87 @@
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#pragma once
+#include <QHash>
+#include <QString>
+#include <QStringView>
+#include <QVector>
+#include "fileitem.h"
+#include "foldedsearch.h"
+#include "rowbitmap.h"
+#include "trigramindex.h"
+#include <memory>
+
+// Column store of the queryable fields of a ThumbnailModel, row-aligned with it.
+// Built once per directory load so the filter can scan plain arrays instead of
+// going through QVariant roles and building FileItems.
+class SearchIndex {
+public:
+    void clear();
+    void reserve(int rows);
+    void append(const FileItem& item); // appends as row rowCount()
+    void setTags(int row, const QStringList& tags);
+    // Many rows at once (a tag renamed): one pass over the id array, one new generation
+    void setTags(const QHash<int, QStringList>& tagsByRow);
+
+    int rowCount() const { return m_years.size(); }
+
+    // Bumped on every mutation, unique across instances: lets consumers cache
+    // index-derived data (e.g. resolved tag ids) and notice when it goes stale.
+    quint64 generation() const { return m_generation; }
+
+    // All folded names back to back; row r is [nameOffset(r), nameOffset(r + 1)).
+    // One buffer lets a substring search run over many rows per call.
+    QStringView names() const { return m_names; }
+    int nameOffset(int row) const { return m_nameOffsets[row]; }
+
+    QStringView foldedName(int row) const {
+        const int off = m_nameOffsets[row];
+        return QStringView(m_names).mid(off, m_nameOffsets[row + 1] - off);
+    }
+    const int* tagIdsBegin(int row) const { return m_tagIds.constData() + m_tagOffsets[row]; }
+    const int* tagIdsEnd(int row) const { return m_tagIds.constData() + m_tagOffsets[row + 1]; }
+    int year(int row) const { return m_years[row]; }
+    qint64 size(int row) const { return m_sizes[row]; }
+    FileKind kind(int row) const { return FileKind(m_kinds[row]); }
+
+    // -1 if no row carries that tag. Expects fold()ed input.
+    int tagId(const QString& foldedTag) const { return m_tagIdByName.value(foldedTag, -1); }
+
+    // Inverted indexes; tagId -1 yields the empty set
+    const RowBitmap& rowsWithTag(int tagId) const;
+    const RowBitmap& rowsOfKind(FileKind kind) const { return m_rowsByKind[int(kind)]; }
+
+    // Built in the background after a load; null until then (callers scan instead).
+    // Ignored if it was built for a different row count.
+    void setTrigrams(std::shared_ptr<const TrigramIndex> trigrams);
+    const TrigramIndex* trigrams() const { return m_trigrams.get(); }
+
+    static QString fold(const QString& s) { return FoldedSearch::fold(s); }
+
+private:
+    int internTag(const QString& foldedTag);
+    void touch();
+
+    // Names of all rows back to back; row r is [m_nameOffsets[r], m_nameOffsets[r+1])
+    QString m_names;
+    QVector<int> m_nameOffsets{0};
+
+    // Same layout for tag ids
+    QVector<int> m_tagIds;
+    QVector<int> m_tagOffsets{0};
+
+    QVector<int> m_years;     // 0 if mtime unknown
+    QVector<qint64> m_sizes;
+    QVector<quint8> m_kinds;
+
+    QHash<QString, int> m_tagIdByName;
+    QVector<QString> m_tagNames;
+    QVector<RowBitmap> m_rowsByTag;  // by tag id
+    RowBitmap m_rowsByKind[4];       // by FileKind
+    std::shared_ptr<const TrigramIndex> m_trigrams; // names only, so tag edits keep it valid
+
+    quint64 m_generation = 0;
+};
+
+#endif // SEARCHINDEX_H
@@ -0,0 +1,323 @@
+#include "sidecarimporter.h"
+
+#include "taggerstore.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMetaObject>
+#include <QPointer>
+#include <QRunnable>
+#include <QThread>
+#include <atomic>
+#include <cstring>
+#include <functional>
+
+namespace {
+
+// Recursive descent over a sidecar's bytes that decodes only tags[].title and
+// skips everything else. Lenient about what it skips (escapes, number syntax).
+class Scanner {
+public:
+    Scanner(const char* begin, const char* end) : m_p(begin), m_end(end) {
+        if (m_end - m_p >= 3 && std::memcmp(m_p, "\xEF\xBB\xBF", 3) == 0) m_p += 3; // UTF-8 BOM
+    }
+
+    bool document(QStringList* tags) {
+        ws();
+        const bool ok = object([&](const Span& key) {
+            return key.is("tags") ? tagList(tags) : skipValue();
+        });
+        ws();
+        return ok && m_p == m_end;
+    }
+
+private:
+    static constexpr int kMaxDepth = 256;
+
+    // A string's raw bytes, between the quotes
+    struct Span {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        bool escaped = false;
+
+        bool is(const char* word) const {
+            if (!escaped) {
+                const size_t n = std::strlen(word);
+                return size_t(end - begin) == n && std::memcmp(begin, word, n) == 0;
+            }
+            return decode() == QLatin1String(word);
+        }
+
+        QString decode() const {
+            if (!escaped) return QString::fromUtf8(begin, int(end - begin));
+            QString out;
+            const char* run = begin;
+            for (const char* p = begin; p < end; ++p) {
+                if (*p != '\\') continue;
+                out += QString::fromUtf8(run, int(p - run));
+                if (++p == end) break;
+                switch (*p) {
+                case 'n': out += QLatin1Char('\n'); break;
+                case 't': out += QLatin1Char('\t'); break;
+                case 'r': out += QLatin1Char('\r'); break;
+                case 'b': out += QLatin1Char('\b'); break;
+                case 'f': out += QLatin1Char('\f'); break;
+                case 'u':
+                    // UTF-16 unit; a surrogate pair arrives as two of these, in order
+                    if (end - p > 4) {
+                        bool ok = false;
+                        const ushort unit = QByteArray(p + 1, 4).toUShort(&ok, 16);
+                        if (ok) out += QChar(unit);
+                        p += 4;
+                    }
+                    break;
+                default: out += QLatin1Char(*p); break; // \" \\ \/
+                }
+                run = p + 1;
+            }
+            out += QString::fromUtf8(run, int(end - run));
+            return out;
+        }
+    };
+
+    char peek() const { return m_p < m_end ? *m_p : '\0'; }
+
+    bool eat(char c) {
+        if (peek() != c) return false;
+        ++m_p;
+        return true;
+    }
+
+    void ws() {
+        while (m_p < m_end && (*m_p == ' ' || *m_p == '\n' || *m_p == '\r' || *m_p == '\t')) ++m_p;
+    }
+
+    bool string(Span* out) {
+        if (!eat('"')) return false;
+        out->begin = m_p;
+        out->escaped = false;
+        while (m_p < m_end) {
+            const char c = *m_p;
+            if (c == '"') {
+                out->end = m_p++;
+                return true;
+            }
+            if (c == '\\') {
+                out->escaped = true;
+                m_p += 2;
+            } else if (uchar(c) < 0x20) {
+                return false;
+            } else {
+                ++m_p;
+            }
+        }
+        return false;
+    }
+
+    // member(key) is called with the input at the value
+    template <typename Member>
+    bool object(Member member) {
+        if (!eat('{')) return false;
+        ws();
+        if (eat('}')) return true;
+        if (++m_depth > kMaxDepth) return false;
+        forever {
+            ws();
+            Span key;
+            if (!string(&key)) return false;
+            ws();
+            if (!eat(':')) return false;
+            ws();
+            if (!member(key)) return false;
+            ws();
+            if (eat(',')) continue;
+            --m_depth;
+            return eat('}');
+        }
+    }
+
+    // element() is called with the input at each value
+    template <typename Element>
+    bool array(Element element) {
+        if (!eat('[')) return false;
+        ws();
+        if (eat(']')) return true;
+        if (++m_depth > kMaxDepth) return false;
+        forever {
+            ws();
+            if (!element()) return false;
+            ws();
+            if (eat(',')) continue;
+            --m_depth;
+            return eat(']');
+        }
+    }
+
+    bool skipValue() {
+        switch (peek()) {
+        case '{': return object([this](const Span&) { return skipValue(); });
+        case '[': return array([this] { return skipValue(); });
+        case '"': {
+            Span s;
+            return string(&s);
+        }
+        default: {
+            // Number, true, false or null
+            const char* start = m_p;
+            while (m_p < m_end && !std::strchr(",]} \t\r\n", *m_p)) ++m_p;
+            return m_p != start;
+        }
+        }
+    }
+
+    // "tags": [{"title": "..."}, ...]; anything else under "tags" means no tags
+    bool tagList(QStringList* tags) {
+        tags->clear();
+        if (peek() != '[') return skipValue();
+        return array([this, tags] {
+            if (peek() != '{') return skipValue();
+            QString title;
+            const bool ok = object([this, &title](const Span& key) {
+                if (!key.is("title") || peek() != '"') return skipValue();
+                Span value;
+                if (!string(&value)) return false;
+                title = value.decode().trimmed();
+                return true;
+            });
+            if (ok && !title.isEmpty()) *tags << title;
+            return ok;
+        });
+    }
+
+    const char* m_p;
+    const char* m_end;
+    int m_depth = 0;
+};
+
+// Sidecars under dirPath whose mtime differs from their last import, parsed
+// (over parsers, if given) and handed to the store in one write
+int importChanged(TaggerStore* store, const QString& dirPath, const QFileInfoList& sidecars,
+                  QThreadPool* parsers) {
+    if (sidecars.isEmpty()) return 0;
+    const QHash<QString, qint64> known = store->loadSidecarImportsUnder(dirPath);
+
+    QVector<TaggerStore::SidecarTags> todo;
+    for (const QFileInfo& fi : sidecars) {
+        const QString sidecar = fi.absoluteFilePath();
+        const qint64 mtime = fi.lastModified().toSecsSinceEpoch();
+        const auto k = known.constFind(sidecar);
+        if (k != known.constEnd() && k.value() == mtime) continue;
+
+        // <folder>/.ts/<name>.json describes <folder>/<name>
+        const QString path = QFileInfo(fi.absolutePath()).path() + '/' + fi.completeBaseName();
+        if (!QFileInfo::exists(path)) continue;
+        todo.push_back({sidecar, mtime, path, std::nullopt});
+    }
+    if (todo.isEmpty()) return 0;
+
+    auto parse = [&todo](int from, int to) {
+        for (int i = from; i < to; ++i) {
+            QFile f(todo[i].sidecar);
+            if (f.open(QIODevice::ReadOnly)) todo[i].tags = SidecarImporter::parseTags(f.readAll());
+        }
+    };
+
+    static constexpr int kChunk = 64; // sidecars per parse job
+    if (!parsers || todo.size() <= kChunk) {
+        parse(0, todo.size());
+    } else {
+        struct Job : public QRunnable {
+            std::function<void()> fn;
+            explicit Job(std::function<void()> f) : fn(std::move(f)) {}
+            void run() override { fn(); }
+        };
+        for (int from = 0; from < todo.size(); from += kChunk) {
+            const int to = qMin(from + kChunk, int(todo.size()));
+            auto* job = new Job([&parse, from, to] { parse(from, to); }); // each writes its own slots
+            job->setAutoDelete(true);
+            parsers->start(job);
+        }
+        parsers->waitForDone();
+    }
+
+    return store->importSidecarTags(todo);
+}
+
+} // namespace
+
+SidecarImporter::SidecarImporter(TaggerStore* store, QObject* parent)
+    : QObject(parent), m_store(store) {
+    m_pool.setMaxThreadCount(1); // one workspace at a time; each parses in parallel
+}
+
+SidecarImporter::~SidecarImporter() {
+    m_cancel = true;
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void SidecarImporter::importWorkspace(const QString& root) {
+    if (!m_store || root.isEmpty()) return;
+
+    struct Job : public QRunnable {
+        QPointer<SidecarImporter> importer;
+        TaggerStore* store;
+        QString root;
+        const std::atomic<bool>* cancel;
+
+        Job(QPointer<SidecarImporter> i, TaggerStore* s, const QString& r, const std::atomic<bool>* c)
+            : importer(i), store(s), root(r), cancel(c) {}
+
+        void run() override {
+            if (!importer) return;
+            QElapsedTimer timer;
+            timer.start();
+
+            // Hidden folders (.git, .cache...) are not walked: the only one that
+            // matters is each folder's own .ts
+            QFileInfoList sidecars;
+            QStringList dirs{root};
+            while (!dirs.isEmpty()) {
+                if (*cancel) return;
+                const QDir dir(dirs.takeLast());
+                sidecars += QDir(dir.filePath(".ts")).entryInfoList({"*.json"}, QDir::Files | QDir::Hidden);
+                for (const QString& sub : dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks)) {
+                    dirs << dir.filePath(sub);
+                }
+            }
+
+            QThreadPool parsers;
+            parsers.setMaxThreadCount(QThread::idealThreadCount());
+            const int files = importChanged(store, root, sidecars, &parsers);
+            qCDebug(lcStore) << "Sidecars under" << root << ":" << sidecars.size() << "found," << files
+                             << "imported in" << timer.elapsed() << "ms";
+
+            QPointer<SidecarImporter> imp = importer;
+            QMetaObject::invokeMethod(imp, [imp, root = root, files]() {
+                if (imp) emit imp->imported(root, files);
+            }, Qt::QueuedConnection);
+        }
+    };
+
+    auto* job = new Job(QPointer<SidecarImporter>(this), m_store, QDir(root).absolutePath(), &m_cancel);
+    job->setAutoDelete(true);
+    m_pool.start(job);
+}
+
+int SidecarImporter::importFolder(TaggerStore* store, const QString& dirPath) {
+    if (!store) return 0;
+    const QDir tsDir(QDir(dirPath).absoluteFilePath(".ts"));
+    if (!tsDir.exists()) return 0;
+    return importChanged(store, tsDir.absolutePath(),
+                         tsDir.entryInfoList({"*.json"}, QDir::Files | QDir::Hidden), nullptr);
+}
+
+std::optional<QStringList> SidecarImporter::parseTags(const QByteArray& json) {
+    QStringList tags;
+    Scanner scanner(json.constData(), json.constData() + json.size());
+    if (!scanner.document(&tags)) return std::nullopt;
+    return tags;
+}
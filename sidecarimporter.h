@@ -0,0 +1,46 @@
+#ifndef SIDECARIMPORTER_H
+#define SIDECARIMPORTER_H
+
+#pragma once
+#include <QByteArray>
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+#include <atomic>
+#include <optional>
+
+class TaggerStore;
+
+// Moves tags from .ts/<name>.json sidecars into the store, where they are read
+// like any other tags. Only sidecars whose mtime changed since their last import
+// are parsed; a sidecar never overrides tags edited in the app after it was
+// written (see TaggerStore::importSidecarTags()).
+class SidecarImporter : public QObject {
+    Q_OBJECT
+public:
+    explicit SidecarImporter(TaggerStore* store, QObject* parent = nullptr);
+    ~SidecarImporter() override;
+
+    // Background: every sidecar under root, parsed in parallel, one write.
+    // Workspaces queue up behind each other. Result via imported(). Meant for a
+    // workspace just added or an explicit re-import; browsing keeps folders up to
+    // date as they are listed (importFolder()).
+    void importWorkspace(const QString& root);
+
+    // Blocking, for the thread listing dirPath: just dirPath/.ts
+    static int importFolder(TaggerStore* store, const QString& dirPath);
+
+    // tags[].title of a sidecar, trimmed, empty ones dropped; none if it is not
+    // a JSON object. One pass over the bytes, no document built.
+    static std::optional<QStringList> parseTags(const QByteArray& json);
+
+signals:
+    void imported(const QString& root, int files); // files whose tags were set
+
+private:
+    TaggerStore* m_store = nullptr; // owned by MainWindow, must outlive this (jobs use it)
+    QThreadPool m_pool;
+    std::atomic<bool> m_cancel{false}; // set on destruction: a running walk stops
+};
+
+#endif // SIDECARIMPORTER_H
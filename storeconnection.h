@@ -0,0 +1,83 @@
+#ifndef STORECONNECTION_H
+#define STORECONNECTION_H
+
+#pragma once
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QLoggingCategory>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+Q_DECLARE_LOGGING_CATEGORY(lcStore)
+
+// One SQLite connection plus the prepared statements used on it. Each distinct
+// SQL text is prepared once and reused for the lifetime of the connection;
+// StoreStatement is the per-call handle. Not thread-safe: one thread per instance,
+// the one that opened it. Statement stats are logged when it is destroyed.
+class StoreConnection {
+public:
+    StoreConnection() = default;
+    ~StoreConnection();
+    StoreConnection(const StoreConnection&) = delete;
+    StoreConnection& operator=(const StoreConnection&) = delete;
+
+    // readOnly connections never take the write lock; under WAL they read concurrently
+    // with each other and with the single writer. Applies the tuning profile
+    // (cache, temp store, checkpoints) for the role.
+    bool open(const QString& dbPath, const QString& connectionName, bool readOnly = false);
+    void close();
+    bool isOpen() const { return m_db.isOpen(); }
+
+    // For one-off statements (schema, pragmas) that are not worth caching
+    QSqlDatabase database() const { return m_db; }
+
+    struct StatementStats {
+        QString sql;
+        qint64 calls = 0;
+        qint64 totalNs = 0; // exec through finish, i.e. including row fetches
+        qint64 maxNs = 0;
+    };
+    QVector<StatementStats> stats() const; // most total time first
+    void logStats() const;                 // to tagger.store (debug)
+
+private:
+    friend class StoreStatement;
+
+    struct Entry {
+        QSqlQuery query;
+        StatementStats stats;
+    };
+
+    Entry* prepared(const char* sql);
+
+    QSqlDatabase m_db;
+    QString m_name;
+    QHash<QByteArray, Entry*> m_statements; // owned; keyed by SQL text
+};
+
+// One execution of a cached statement: bind positionally, exec, read rows.
+// The statement is reset (finish()) and its latency recorded on destruction.
+class StoreStatement {
+public:
+    StoreStatement(StoreConnection& conn, const char* sql);
+    ~StoreStatement();
+    StoreStatement(const StoreStatement&) = delete;
+    StoreStatement& operator=(const StoreStatement&) = delete;
+
+    StoreStatement& bind(const QVariant& value); // next '?'
+    bool exec();
+    bool next() { return m_entry && m_entry->query.next(); }
+    QVariant value(int column) const { return m_entry ? m_entry->query.value(column) : QVariant(); }
+    QString lastError() const;
+
+private:
+    StoreConnection::Entry* m_entry = nullptr; // null if the SQL failed to prepare
+    int m_bound = 0;
+    QElapsedTimer m_timer;
+};
+
+#endif // STORECONNECTION_H
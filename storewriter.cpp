@@ -0,0 +1,261 @@
+#include "storewriter.h"
+
+#include "storeconnection.h"
+
+#include <QElapsedTimer>
+#include <QSqlError>
+#include <QSqlQuery>
+
+StoreWriter::StoreWriter(QObject* parent) : QThread(parent) {}
+
+StoreWriter::~StoreWriter() {
+    stop();
+}
+
+void StoreWriter::open(const QString& dbPath, std::function<bool(QSqlDatabase&)> init) {
+    if (isRunning()) return;
+    m_dbPath = dbPath;
+    m_init = std::move(init);
+    m_stopping = false;
+    m_openState = OpenState::Opening;
+    start();
+}
+
+bool StoreWriter::waitUntilOpen() const {
+    QMutexLocker lock(&m_lock);
+    while (m_openState == OpenState::Opening) m_done.wait(&m_lock);
+    return m_openState == OpenState::Open;
+}
+
+void StoreWriter::stop() {
+    if (!isRunning()) return;
+    {
+        QMutexLocker lock(&m_lock);
+        m_stopping = true;
+        m_wake.wakeOne();
+    }
+    wait();
+    m_openState = OpenState::Closed;
+    logStats();
+}
+
+void StoreWriter::enqueue(const char* sql, const QVariantList& binds, const QStringList& keys, Done done) {
+    enqueue(QVector<Step>{{sql, binds}}, keys, std::move(done));
+}
+
+void StoreWriter::enqueue(const QVector<Step>& steps, const QStringList& keys, Done done) {
+    if (!isRunning()) { // no database (open failed): writes go nowhere, as before
+        if (done) done(false);
+        return;
+    }
+
+    QMutexLocker lock(&m_lock);
+    const bool wasEmpty = m_queue.isEmpty();
+    if (wasEmpty) m_deadline.setRemainingTime(kFlushMs);
+    m_queue.push_back({steps, keys, std::move(done)});
+    for (const QString& k : keys) ++m_pendingKeys[k];
+    ++m_enqueued;
+
+    m_stats.queueDepth = m_queue.size();
+    m_stats.maxQueueDepth = qMax(m_stats.maxQueueDepth, m_stats.queueDepth);
+    // First write arms the writer's deadline; a full batch goes right away
+    if (wasEmpty || m_queue.size() >= kMaxBatch) m_wake.wakeOne();
+}
+
+void StoreWriter::flush() {
+    if (!isRunning()) return;
+    QMutexLocker lock(&m_lock);
+    const quint64 target = m_enqueued;
+    if (m_committed >= target) return;
+    m_flushRequested = true;
+    m_wake.wakeOne();
+    while (m_committed < target) m_done.wait(&m_lock);
+}
+
+bool StoreWriter::isPending(const QString& key) const {
+    QMutexLocker lock(&m_lock);
+    return m_pendingKeys.contains(key);
+}
+
+bool StoreWriter::isPendingUnder(const QString& prefix) const {
+    QMutexLocker lock(&m_lock);
+    for (auto it = m_pendingKeys.cbegin(); it != m_pendingKeys.cend(); ++it) {
+        if (it.key().startsWith(prefix)) return true;
+    }
+    return false;
+}
+
+StoreWriter::Stats StoreWriter::stats() const {
+    QMutexLocker lock(&m_lock);
+    return m_stats;
+}
+
+void StoreWriter::logStats() const {
+    if (!lcStore().isDebugEnabled()) return;
+    const Stats s = stats();
+    qCDebug(lcStore).noquote()
+        << QString("writer: %1 writes (%2 failed) in %3 commits, avg commit %4 ms, max %5 ms, max queue %6, "
+                   "vacuumed %7 KiB")
+               .arg(s.writes)
+               .arg(s.failedWrites)
+               .arg(s.commits)
+               .arg(s.commits ? s.totalCommitNs / 1e6 / s.commits : 0.0, 0, 'f', 2)
+               .arg(s.maxCommitNs / 1e6, 0, 'f', 2)
+               .arg(s.maxQueueDepth)
+               .arg(s.vacuumedBytes / 1024);
+}
+
+void StoreWriter::run() {
+    StoreConnection conn;
+    bool ok = conn.open(m_dbPath, "tagger-writer");
+    if (ok) {
+        QSqlDatabase db = conn.database();
+        QSqlQuery(db).exec("PRAGMA busy_timeout=5000;");
+        if (m_init) ok = m_init(db);
+    }
+    {
+        QMutexLocker lock(&m_lock);
+        m_openState = ok ? OpenState::Open : OpenState::Failed;
+        m_done.wakeAll();
+    }
+    emit opened(ok);
+
+    // Pages on the free list, left by deletes; vacuumed while idle
+    qint64 pageSize = 0;
+    auto freePages = [&conn]() -> qint64 {
+        QSqlQuery q(conn.database());
+        return q.exec("PRAGMA freelist_count;") && q.next() ? q.value(0).toLongLong() : 0;
+    };
+    qint64 freeList = 0;
+    if (ok) {
+        QSqlQuery q(conn.database());
+        if (q.exec("PRAGMA page_size;") && q.next()) pageSize = q.value(0).toLongLong();
+        freeList = freePages();
+    }
+
+    // Keeps planner statistics current for long sessions; cheap when nothing changed
+    QElapsedTimer sinceOptimize;
+    sinceOptimize.start();
+
+    forever {
+        QVector<Write> batch;
+        bool stopping = false;
+        bool idle = false;
+        {
+            QMutexLocker lock(&m_lock);
+            // Sleep until there is work and either its deadline passed, the batch is
+            // full, someone waits on flush(), or we are asked to stop. With free
+            // pages to give back, also wake up after a quiet spell.
+            while (!m_stopping && !m_flushRequested && m_queue.size() < kMaxBatch) {
+                if (m_queue.isEmpty()) {
+                    if (freeList <= 0) m_wake.wait(&m_lock);
+                    else if (!m_wake.wait(&m_lock, kIdleVacuumMs) && m_queue.isEmpty()) {
+                        idle = true;
+                        break;
+                    }
+                } else if (!m_wake.wait(&m_lock, m_deadline)) break;
+            }
+            batch.swap(m_queue);
+            m_flushRequested = false;
+            m_stats.queueDepth = 0;
+            stopping = m_stopping;
+        }
+
+        if (!batch.isEmpty()) {
+            QElapsedTimer timer;
+            timer.start();
+
+            // Per write; with no database they are all dropped, as with no database at all
+            QVector<bool> committed(batch.size(), false);
+            if (ok) {
+                QSqlDatabase db = conn.database();
+                db.transaction();
+                QSqlQuery sp(db);
+                for (int i = 0; i < batch.size(); ++i) {
+                    const Write& w = batch[i];
+                    // A failing write must not take the rest of the batch with it
+                    const bool group = w.steps.size() > 1;
+                    if (group) sp.exec("SAVEPOINT write;");
+                    bool failed = false;
+                    for (const Step& step : w.steps) {
+                        StoreStatement st(conn, step.sql);
+                        for (const QVariant& v : step.binds) st.bind(v);
+                        if (!st.exec()) {
+                            qWarning() << "DB write failed:" << st.lastError() << "SQL:" << step.sql;
+                            failed = true;
+                            break;
+                        }
+                    }
+                    if (group && failed) sp.exec("ROLLBACK TO write;");
+                    if (group) sp.exec("RELEASE write;");
+                    committed[i] = !failed;
+                }
+                if (!db.commit()) {
+                    qWarning() << "DB commit failed:" << db.lastError().text();
+                    db.rollback();
+                    committed.fill(false);
+                }
+            }
+            const qint64 ns = timer.nsecsElapsed();
+
+            // Before waking flush()es, so a flusher sees the outcome of its writes
+            int failed = 0;
+            for (int i = 0; i < batch.size(); ++i) {
+                if (!committed[i]) ++failed;
+                if (batch[i].done) batch[i].done(committed[i]);
+            }
+
+            QMutexLocker lock(&m_lock);
+            for (const Write& w : batch) {
+                for (const QString& k : w.keys) {
+                    auto it = m_pendingKeys.find(k);
+                    if (it != m_pendingKeys.end() && --it.value() <= 0) m_pendingKeys.erase(it);
+                }
+            }
+            m_committed += quint64(batch.size());
+            ++m_stats.commits;
+            m_stats.writes += batch.size();
+            m_stats.failedWrites += failed;
+            m_stats.totalCommitNs += ns;
+            m_stats.maxCommitNs = qMax(m_stats.maxCommitNs, ns);
+            m_done.wakeAll();
+
+            if (ok && sinceOptimize.elapsed() > kOptimizeMs) {
+                QSqlQuery(conn.database()).exec("PRAGMA optimize;");
+                sinceOptimize.restart();
+            }
+            if (ok) freeList = freePages();
+        }
+
+        if (idle && ok) {
+            // Small slices keep the write lock short; a write arriving meanwhile
+            // waits for at most one of them
+            QSqlQuery q(conn.database());
+            if (q.exec(QString("PRAGMA incremental_vacuum(%1);").arg(kVacuumPages))) {
+                while (q.next()) {} // step it to the end, or it may stop after a page
+            }
+            q.finish();
+            const qint64 before = freeList;
+            freeList = freePages();
+            if (freeList >= before) {
+                freeList = 0; // no progress (auto_vacuum off?): wait for the next commit
+            } else {
+                QMutexLocker lock(&m_lock);
+                m_stats.vacuumedBytes += (before - freeList) * pageSize;
+            }
+        }
+
+        if (stopping) {
+            QMutexLocker lock(&m_lock);
+            if (m_queue.isEmpty()) break;
+        }
+    }
+
+    if (ok) {
+        // Leave a small database behind: fold the WAL back in and truncate it
+        QSqlQuery q(conn.database());
+        q.exec("PRAGMA optimize;");
+        if (!q.exec("PRAGMA wal_checkpoint(TRUNCATE);"))
+            qWarning() << "DB checkpoint failed:" << q.lastError().text();
+    }
+}
@@ -0,0 +1,111 @@
+#ifndef STOREWRITER_H
+#define STOREWRITER_H
+
+#pragma once
+#include <QDeadlineTimer>
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+#include <QThread>
+#include <QVariantList>
+#include <QVector>
+#include <QWaitCondition>
+#include <functional>
+
+class QSqlDatabase;
+
+// Write-behind queue for TaggerStore: writes are queued from any thread and a
+// dedicated thread with its own connection commits them in grouped transactions,
+// once kFlushMs passed since the oldest queued write or kMaxBatch are waiting.
+// Each write names the keys it touches so readers can wait for just those.
+// The thread owns the only read-write connection, schema setup included.
+// While the queue stays empty it hands free pages back to the file system, a
+// slice at a time (PRAGMA incremental_vacuum; needs auto_vacuum=INCREMENTAL).
+class StoreWriter : public QThread {
+    Q_OBJECT
+public:
+    static constexpr int kFlushMs = 50;
+    static constexpr int kMaxBatch = 256;
+    static constexpr qint64 kOptimizeMs = 60 * 60 * 1000; // PRAGMA optimize at most hourly, and on stop
+    static constexpr int kIdleVacuumMs = 2000; // quiet this long before a vacuum slice
+    static constexpr int kVacuumPages = 128;   // per slice: 512 KiB with 4 KiB pages
+
+    explicit StoreWriter(QObject* parent = nullptr);
+    ~StoreWriter() override; // stop()
+
+    // Starts the thread, which opens the connection and runs init (schema) on it
+    // before taking writes; writes queued meanwhile wait. Result via opened().
+    void open(const QString& dbPath, std::function<bool(QSqlDatabase&)> init = {});
+    void stop(); // commits what is queued, then ends the thread
+
+    // Blocks until open() finished; false if the database is unusable
+    bool waitUntilOpen() const;
+
+    struct Step {
+        const char* sql; // a string literal (statements are cached by it)
+        QVariantList binds;
+    };
+
+    // Called on the writer thread once the write is committed (true) or failed
+    // and rolled back (false), before flush()es waiting for it return. Must not
+    // wait on the writer: no flush(), no reads of keys it may still hold.
+    using Done = std::function<void(bool committed)>;
+
+    void enqueue(const char* sql, const QVariantList& binds, const QStringList& keys, Done done = {});
+    // All steps or none: they share the batch's transaction under a savepoint
+    void enqueue(const QVector<Step>& steps, const QStringList& keys, Done done = {});
+
+    // Durability barrier: returns once every write queued before the call is committed
+    void flush();
+
+    // A queued or in-flight write touches key
+    bool isPending(const QString& key) const;
+    // ... a key starting with prefix (a scan, but only over pending keys)
+    bool isPendingUnder(const QString& prefix) const;
+
+    struct Stats {
+        int queueDepth = 0;
+        int maxQueueDepth = 0;
+        qint64 commits = 0;
+        qint64 writes = 0;
+        qint64 failedWrites = 0;
+        qint64 totalCommitNs = 0;
+        qint64 maxCommitNs = 0;
+        qint64 vacuumedBytes = 0; // given back by incremental vacuum
+    };
+    Stats stats() const;
+    void logStats() const; // to tagger.store (debug)
+
+signals:
+    void opened(bool ok); // from the writer thread
+
+protected:
+    void run() override;
+
+private:
+    struct Write {
+        QVector<Step> steps;
+        QStringList keys;
+        Done done;
+    };
+
+    enum class OpenState { Closed, Opening, Open, Failed };
+
+    mutable QMutex m_lock;
+    QWaitCondition m_wake;         // writer: work, flush or stop
+    mutable QWaitCondition m_done; // flushers: a batch was committed; waiters: open finished
+
+    QString m_dbPath;
+    std::function<bool(QSqlDatabase&)> m_init;
+    OpenState m_openState = OpenState::Closed;
+    QVector<Write> m_queue;
+    QHash<QString, int> m_pendingKeys; // queued + in-flight writes per key
+    QDeadlineTimer m_deadline;         // commit the queue by then
+    quint64 m_enqueued = 0;
+    quint64 m_committed = 0;           // done (committed or failed) in enqueue order
+    bool m_flushRequested = false;
+    bool m_stopping = false;
+    Stats m_stats;
+};
+
+#endif // STOREWRITER_H
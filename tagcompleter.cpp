@@ -0,0 +1,146 @@
+#include "tagcompleter.h"
+
+#include "tagdictionary.h"
+
+#include <QAbstractItemView>
+#include <QCompleter>
+#include <QKeyEvent>
+#include <QLineEdit>
+#include <QScrollBar>
+#include <QSet>
+#include <QStringListModel>
+#include <QTextCursor>
+#include <QTextEdit>
+#include <algorithm>
+
+static constexpr int kShown = 8;
+
+// Same word breaks as QueryMatcher's lexer
+static bool isQueryDelim(QChar c) {
+    return c.isSpace() || c == '&' || c == '|' || c == '<' || c == '>' || c == '=';
+}
+
+TagCompleter::TagCompleter(TagDictionary* dictionary, QWidget* editor, Mode mode)
+    : QObject(editor), m_dictionary(dictionary), m_mode(mode) {
+    m_model = new QStringListModel(this);
+    m_completer = new QCompleter(m_model, this);
+    m_completer->setWidget(editor);
+    m_completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion); // ranked by the dictionary
+    m_completer->setMaxVisibleItems(kShown);
+    // Ahead of QCompleter's own filter, which would also pass Enter/Tab on to the editor
+    m_completer->popup()->installEventFilter(this);
+    connect(m_completer, QOverload<const QString&>::of(&QCompleter::activated), this, &TagCompleter::insert);
+}
+
+TagCompleter::TagCompleter(TagDictionary* dictionary, QLineEdit* editor, Mode mode)
+    : TagCompleter(dictionary, static_cast<QWidget*>(editor), mode) {
+    m_lineEdit = editor;
+    connect(editor, &QLineEdit::textEdited, this, &TagCompleter::update);
+}
+
+TagCompleter::TagCompleter(TagDictionary* dictionary, QTextEdit* editor, Mode mode)
+    : TagCompleter(dictionary, static_cast<QWidget*>(editor), mode) {
+    m_textEdit = editor;
+    connect(editor, &QTextEdit::textChanged, this, &TagCompleter::update);
+}
+
+QString TagCompleter::textBeforeCursor() const {
+    if (m_lineEdit) return m_lineEdit->text().left(m_lineEdit->cursorPosition());
+    if (m_textEdit) return m_textEdit->toPlainText().left(m_textEdit->textCursor().position());
+    return {};
+}
+
+int TagCompleter::wordStart(const QString& before) const {
+    int i = before.size();
+    while (i > 0) {
+        const QChar c = before[i - 1];
+        if (m_mode == Mode::TagList ? (c == ',' || c == '\n') : isQueryDelim(c)) break;
+        --i;
+    }
+    while (i < before.size() && before[i].isSpace()) ++i;
+    return i;
+}
+
+void TagCompleter::update() {
+    QAbstractItemView* popup = m_completer->popup();
+    QWidget* editor = m_completer->widget();
+    if (m_inserting || !m_dictionary || !editor || !editor->hasFocus()) return;
+
+    const QString before = textBeforeCursor();
+    const QString word = before.mid(wordStart(before)).trimmed();
+    QStringList tags;
+    if (!word.isEmpty()) {
+        // Ask for extra to make up for names dropped below
+        const QStringList candidates = m_dictionary->complete(word, kShown * 2);
+        QSet<QString> present;
+        if (m_mode == Mode::TagList && m_textEdit) {
+            for (const QString& t : m_textEdit->toPlainText().split(',', Qt::SkipEmptyParts))
+                present.insert(t.trimmed());
+        }
+        for (const QString& t : candidates) {
+            if (present.contains(t)) continue;
+            if (m_mode == Mode::Query && std::any_of(t.cbegin(), t.cend(), isQueryDelim)) continue;
+            tags << t;
+            if (tags.size() == kShown) break;
+        }
+        // The word already is the one suggestion
+        if (tags.size() == 1 && tags.first().compare(word, Qt::CaseInsensitive) == 0) tags.clear();
+    }
+    if (tags.isEmpty()) {
+        popup->hide();
+        return;
+    }
+
+    m_model->setStringList(tags);
+    QRect rect; // line edit: below the whole field
+    if (m_textEdit) {
+        rect = m_textEdit->cursorRect();
+        rect.setWidth(popup->sizeHintForColumn(0) + popup->verticalScrollBar()->sizeHint().width());
+    }
+    m_completer->complete(rect);
+}
+
+void TagCompleter::insert(const QString& tag) {
+    if (tag.isEmpty()) return;
+    const QString before = textBeforeCursor();
+    const int start = wordStart(before);
+    const QString text = tag + (m_mode == Mode::TagList ? QStringLiteral(", ") : QStringLiteral(" "));
+
+    m_inserting = true;
+    if (m_lineEdit) {
+        QString all = m_lineEdit->text();
+        all.replace(start, before.size() - start, text);
+        m_lineEdit->setText(all);
+        m_lineEdit->setCursorPosition(start + text.size());
+    } else if (m_textEdit) {
+        QTextCursor c = m_textEdit->textCursor();
+        c.setPosition(start);
+        c.setPosition(before.size(), QTextCursor::KeepAnchor);
+        c.insertText(text);
+        m_textEdit->setTextCursor(c);
+    }
+    m_inserting = false;
+}
+
+bool TagCompleter::eventFilter(QObject* watched, QEvent* event) {
+    QAbstractItemView* popup = m_completer->popup();
+    if (watched != popup || event->type() != QEvent::KeyPress || !popup->isVisible())
+        return QObject::eventFilter(watched, event);
+
+    const int key = static_cast<QKeyEvent*>(event)->key();
+    QModelIndex current = popup->currentIndex();
+    switch (key) {
+    case Qt::Key_Tab:
+        if (!current.isValid()) current = m_model->index(0, 0);
+        break;
+    case Qt::Key_Return:
+    case Qt::Key_Enter:
+        if (!current.isValid()) return false; // nothing picked: Enter is the editor's
+        break;
+    default:
+        return QObject::eventFilter(watched, event);
+    }
+    popup->hide();
+    insert(current.data().toString());
+    return true;
+}
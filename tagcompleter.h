@@ -0,0 +1,50 @@
+#ifndef TAGCOMPLETER_H
+#define TAGCOMPLETER_H
+
+#pragma once
+#include <QObject>
+#include <QPointer>
+
+class QCompleter;
+class QLineEdit;
+class QStringListModel;
+class QTextEdit;
+class TagDictionary;
+
+// Pops up tag names (TagDictionary::complete()) for the word being typed in a
+// tag editor or the search box. Tab takes the highlighted or first suggestion,
+// Enter the highlighted one; either replaces the word and adds a separator.
+class TagCompleter : public QObject {
+    Q_OBJECT
+public:
+    enum class Mode {
+        TagList, // comma-separated tags
+        Query,   // search box: words between query operators; tags with spaces can't be typed there
+    };
+
+    // Parented to the editor; a null dictionary completes nothing
+    TagCompleter(TagDictionary* dictionary, QLineEdit* editor, Mode mode);
+    TagCompleter(TagDictionary* dictionary, QTextEdit* editor, Mode mode);
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
+private:
+    TagCompleter(TagDictionary* dictionary, QWidget* editor, Mode mode);
+
+    void update();
+    void insert(const QString& tag);
+
+    QString textBeforeCursor() const;
+    int wordStart(const QString& before) const; // where the word being typed begins
+
+    TagDictionary* m_dictionary = nullptr;
+    QPointer<QLineEdit> m_lineEdit;
+    QPointer<QTextEdit> m_textEdit;
+    Mode m_mode;
+    QCompleter* m_completer = nullptr;
+    QStringListModel* m_model = nullptr;
+    bool m_inserting = false; // our own edit: no new popup for it
+};
+
+#endif // TAGCOMPLETER_H
@@ -0,0 +1,127 @@
+#include "tagdictionary.h"
+
+#include "foldedsearch.h"
+
+#include <QSet>
+#include <algorithm>
+
+void TagDictionary::reset(const QVector<Entry>& tags) {
+    QWriteLocker lock(&m_lock);
+    m_nodes = {Node()};
+    m_tags.clear();
+    m_byName.clear();
+    m_tags.reserve(tags.size());
+    m_byName.reserve(tags.size());
+    for (const Entry& e : tags) {
+        const int i = insertLocked(e.name);
+        if (i >= 0) m_tags[i].entry.count += e.count;
+    }
+    m_nodes.squeeze();
+}
+
+int TagDictionary::insertLocked(const QString& name) {
+    const QString trimmed = name.trimmed();
+    if (trimmed.isEmpty()) return -1;
+    const auto found = m_byName.constFind(trimmed);
+    if (found != m_byName.constEnd()) return found.value();
+
+    int node = 0;
+    for (const QChar c : FoldedSearch::fold(trimmed)) {
+        int child = m_nodes[node].firstChild;
+        while (child >= 0 && m_nodes[child].ch != c.unicode()) child = m_nodes[child].next;
+        if (child < 0) {
+            Node n;
+            n.ch = c.unicode();
+            n.next = m_nodes[node].firstChild;
+            child = m_nodes.size();
+            m_nodes.push_back(n);
+            m_nodes[node].firstChild = child;
+        }
+        node = child;
+    }
+
+    const int i = m_tags.size();
+    m_tags.push_back({{trimmed, 0}, m_nodes[node].tag});
+    m_nodes[node].tag = i;
+    m_byName.insert(trimmed, i);
+    return i;
+}
+
+void TagDictionary::bumpLocked(const QString& name, int delta) {
+    const int i = insertLocked(name);
+    if (i >= 0) m_tags[i].entry.count = qMax(0, m_tags[i].entry.count + delta);
+}
+
+void TagDictionary::add(const QStringList& tags) {
+    QWriteLocker lock(&m_lock);
+    for (const QString& t : tags) bumpLocked(t, 1);
+}
+
+void TagDictionary::remove(const QStringList& tags) {
+    QWriteLocker lock(&m_lock);
+    for (const QString& t : tags) bumpLocked(t, -1);
+}
+
+void TagDictionary::replace(const QStringList& before, const QStringList& after) {
+    const QSet<QString> was(before.cbegin(), before.cend());
+    const QSet<QString> now(after.cbegin(), after.cend());
+    QWriteLocker lock(&m_lock);
+    for (const QString& t : was) {
+        if (!now.contains(t)) bumpLocked(t, -1);
+    }
+    for (const QString& t : now) {
+        if (!was.contains(t)) bumpLocked(t, 1);
+    }
+}
+
+QStringList TagDictionary::complete(const QString& prefix, int limit) const {
+    const QString key = FoldedSearch::fold(prefix.trimmed());
+    if (key.isEmpty() || limit <= 0) return {};
+
+    QReadLocker lock(&m_lock);
+    int node = 0;
+    for (const QChar c : key) {
+        int child = m_nodes[node].firstChild;
+        while (child >= 0 && m_nodes[child].ch != c.unicode()) child = m_nodes[child].next;
+        if (child < 0) return {};
+        node = child;
+    }
+
+    // Every name in the subtree still in use, then the best few. A count drops to 0
+    // when its last file is untagged; the node stays, so re-adding it is cheap.
+    QVector<int> hits;
+    QVector<int> stack{node};
+    while (!stack.isEmpty()) {
+        const Node& n = m_nodes[stack.takeLast()];
+        for (int t = n.tag; t >= 0; t = m_tags[t].nextSameKey) {
+            if (m_tags[t].entry.count > 0) hits.push_back(t);
+        }
+        for (int c = n.firstChild; c >= 0; c = m_nodes[c].next) stack.push_back(c);
+    }
+
+    auto better = [this](int a, int b) {
+        const Entry& x = m_tags[a].entry;
+        const Entry& y = m_tags[b].entry;
+        if (x.count != y.count) return x.count > y.count;
+        if (x.name.size() != y.name.size()) return x.name.size() < y.name.size();
+        return x.name.localeAwareCompare(y.name) < 0;
+    };
+    const int n = qMin(limit, int(hits.size()));
+    std::partial_sort(hits.begin(), hits.begin() + n, hits.end(), better);
+
+    QStringList out;
+    out.reserve(n);
+    for (int i = 0; i < n; ++i) out << m_tags[hits[i]].entry.name;
+    return out;
+}
+
+int TagDictionary::count(const QString& name) const {
+    QReadLocker lock(&m_lock);
+    const int i = m_byName.value(name.trimmed(), -1);
+    return i >= 0 ? m_tags[i].entry.count : 0;
+}
+
+int TagDictionary::size() const {
+    QReadLocker lock(&m_lock);
+    return m_tags.size();
+}
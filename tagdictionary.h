@@ -0,0 +1,58 @@
+#ifndef TAGDICTIONARY_H
+#define TAGDICTIONARY_H
+
+#pragma once
+#include <QHash>
+#include <QReadWriteLock>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Every tag name in the library with the number of files tagged with it, in a
+// prefix trie over folded names (FoldedSearch::fold()), so completions are one
+// walk down plus one over the subtree. TaggerStore loads it once and keeps the
+// counts current as tags are saved. Thread-safe.
+class TagDictionary {
+public:
+    struct Entry {
+        QString name;
+        int count = 0; // files tagged (by path)
+    };
+
+    void reset(const QVector<Entry>& tags);
+
+    // One file gained / lost these tags; unknown names are added
+    void add(const QStringList& tags);
+    void remove(const QStringList& tags);
+    void replace(const QStringList& before, const QStringList& after); // the difference only
+
+    // Up to limit names starting with prefix, case-insensitively, among those
+    // tagging at least one file: most used first, then shorter, then alphabetical
+    QStringList complete(const QString& prefix, int limit) const;
+
+    int count(const QString& name) const; // 0 if unknown
+    int size() const;
+
+private:
+    // Children are a sibling list; fan-out past the first levels is tiny
+    struct Node {
+        char16_t ch = 0;
+        int firstChild = -1;
+        int next = -1;
+        int tag = -1; // first of the names folding to this node's key
+    };
+    struct Tag {
+        Entry entry;
+        int nextSameKey = -1; // "Cat" and "cat" share a node
+    };
+
+    int insertLocked(const QString& name); // index into m_tags
+    void bumpLocked(const QString& name, int delta);
+
+    mutable QReadWriteLock m_lock;
+    QVector<Node> m_nodes{Node()}; // [0] is the root
+    QVector<Tag> m_tags;
+    QHash<QString, int> m_byName;
+};
+
+#endif // TAGDICTIONARY_H
@@ -0,0 +1,84 @@
+#include "tageditorbinding.h"
+
+#include "filehasher.h"
+#include "fileitem.h"
+#include "tagcompleter.h"
+#include "taggerstore.h"
+
+#include <QSignalBlocker>
+#include <QTextEdit>
+#include <QTimer>
+
+TagEditorBinding::TagEditorBinding(QTextEdit* editor, const FileItem& item, TaggerStore* store, FileHasher* hasher)
+    : QObject(editor), m_editor(editor), m_store(store), m_hasher(hasher), m_path(item.absolutePath) {
+    m_savedTags = item.tags;
+    show(item.tags);
+    if (!m_store) return;
+
+    new TagCompleter(m_store->tagDictionary(), editor, TagCompleter::Mode::TagList);
+
+    m_saveTimer = new QTimer(this);
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(300);
+    connect(editor, &QTextEdit::textChanged, this, [this] { m_saveTimer->start(); });
+    connect(m_saveTimer, &QTimer::timeout, this, &TagEditorBinding::save);
+
+    if (m_hasher) connect(m_hasher, &FileHasher::hashReady, this, &TagEditorBinding::onHashReady);
+    connect(m_store, &TaggerStore::tagsChanged, this, &TagEditorBinding::onTagsChanged);
+    connect(m_store, &TaggerStore::tagRenamed, this, &TagEditorBinding::onTagRenamed);
+}
+
+QStringList TagEditorBinding::parse(const QString& text) {
+    QStringList out;
+    for (const QString& part : text.split(',', Qt::SkipEmptyParts)) {
+        const QString t = part.trimmed();
+        if (!t.isEmpty()) out << t;
+    }
+    out.removeDuplicates();
+    return out;
+}
+
+void TagEditorBinding::show(const QStringList& tags) {
+    const QSignalBlocker block(m_editor);
+    m_editor->setPlainText(tags.join(", "));
+}
+
+void TagEditorBinding::save() {
+    m_currentTags = parse(m_editor->toPlainText());
+
+    // 1) by path immediately
+    m_pendingSaves << m_store->upsertTagsByPath(m_path, m_currentTags, m_savedTags);
+    m_savedTags = m_currentTags;
+
+    // 2) by hash when available
+    if (m_hasher) m_hasher->request(m_path);
+}
+
+void TagEditorBinding::onHashReady(const QString& path, const QString& hash) {
+    if (path != m_path || m_currentTags.isEmpty()) return;
+    m_store->upsertTagsByHash(hash, m_currentTags);
+}
+
+// Tags changed elsewhere: the editor and what the next save replaces follow, or
+// that save would write the old tags back
+void TagEditorBinding::onTagsChanged(const QString& path, const QStringList& tags, quint64 seq) {
+    if (path != m_path) return;
+    // Our own saves come back in order, once committed; one that failed never does
+    const int own = seq ? m_pendingSaves.indexOf(seq) : -1;
+    if (own >= 0) {
+        m_pendingSaves.erase(m_pendingSaves.begin(), m_pendingSaves.begin() + own + 1);
+        return;
+    }
+    m_savedTags = tags;
+    if (m_saveTimer->isActive()) return; // being edited: that save wins
+    m_currentTags = tags;
+    show(tags);
+}
+
+void TagEditorBinding::onTagRenamed(const QString& from, const QString& to) {
+    m_currentTags = TaggerStore::renamedTags(m_currentTags, from, to);
+    m_savedTags = TaggerStore::renamedTags(m_savedTags, from, to);
+    const QStringList shown = parse(m_editor->toPlainText());
+    const QStringList renamed = TaggerStore::renamedTags(shown, from, to);
+    if (renamed != shown) show(renamed);
+}
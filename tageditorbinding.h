@@ -0,0 +1,44 @@
+#ifndef TAGEDITORBINDING_H
+#define TAGEDITORBINDING_H
+
+#pragma once
+#include <QList>
+#include <QObject>
+#include <QStringList>
+
+class FileHasher;
+class QTextEdit;
+class QTimer;
+class TaggerStore;
+struct FileItem;
+
+// A details tab's tag editor, wired to the store: shows the file's tags, saves
+// them by path 300 ms after the last keystroke and by content hash once the file
+// is hashed, and follows changes made elsewhere (bulk tagging, a sidecar, a
+// rename) so the next save replaces what is stored. Adds a TagCompleter.
+class TagEditorBinding : public QObject {
+    Q_OBJECT
+public:
+    // Parented to the editor; without a store it only shows the tags
+    TagEditorBinding(QTextEdit* editor, const FileItem& item, TaggerStore* store, FileHasher* hasher);
+
+private:
+    void save();
+    void onTagsChanged(const QString& path, const QStringList& tags, quint64 seq);
+    void onTagRenamed(const QString& from, const QString& to);
+    void onHashReady(const QString& path, const QString& hash);
+    void show(const QStringList& tags); // not an edit: no save
+
+    static QStringList parse(const QString& text);
+
+    QTextEdit* m_editor = nullptr;
+    TaggerStore* m_store = nullptr;
+    FileHasher* m_hasher = nullptr;
+    QString m_path;
+    QTimer* m_saveTimer = nullptr;
+    QStringList m_currentTags;
+    QStringList m_savedTags;     // as last saved (or loaded): what a save replaces
+    QList<quint64> m_pendingSaves; // sequence numbers saved here, not yet back through tagsChanged()
+};
+
+#endif // TAGEDITORBINDING_H
@@ -1,53 +1,154 @@
 #include "taggerstore.h"
 
+#include "catalogquery.h"
+#include "fileidentity.h"
+#include "foldedsearch.h"
+
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QVariant>
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QDebug>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QSet>
+#include <atomic>
+#include <iterator>
 
 static qint64 nowSecs() { return QDateTime::currentSecsSinceEpoch(); }
 
-TaggerStore::TaggerStore(QObject* parent) : QObject(parent) {}
+namespace {
 
-bool TaggerStore::openOrCreate(const QString& dbPath) {
-    m_db = QSqlDatabase::addDatabase("QSQLITE", "tagger-conn");
-    m_db.setDatabaseName(dbPath);
-    if (!m_db.open()) {
-        qWarning() << "DB open failed:" << m_db.lastError().text();
-        return false;
-    }
+// Paths below a folder, at any depth: [dir/, dir0), '0' being the character
+// after '/'. One range of any path-keyed index.
+struct PathRange {
+    QString from;
+    QString to;
+};
 
-    QSqlQuery q(m_db);
-    const char* stmts[] = {
-        "PRAGMA journal_mode=WAL;",
-        "PRAGMA synchronous=NORMAL;",
-        "CREATE TABLE IF NOT EXISTS workspaces(dir TEXT PRIMARY KEY, name TEXT NOT NULL, added_at INTEGER NOT NULL);",
-        "CREATE TABLE IF NOT EXISTS app_state(key TEXT PRIMARY KEY, value TEXT NOT NULL);",
-        "CREATE TABLE IF NOT EXISTS open_tabs(path TEXT PRIMARY KEY, opened_at INTEGER NOT NULL);",
-        "CREATE TABLE IF NOT EXISTS tags_by_path(path TEXT PRIMARY KEY, tags_json TEXT NOT NULL, updated_at INTEGER NOT NULL);",
-        "CREATE TABLE IF NOT EXISTS tags_by_hash(hash TEXT PRIMARY KEY, tags_json TEXT NOT NULL, updated_at INTEGER NOT NULL);",
-        "CREATE TABLE IF NOT EXISTS file_hash_cache(path TEXT PRIMARY KEY, size INTEGER NOT NULL, mtime INTEGER NOT NULL, hash TEXT NOT NULL, updated_at INTEGER NOT NULL);",
-        "CREATE INDEX IF NOT EXISTS idx_tags_hash ON tags_by_hash(hash);"
+PathRange subtree(const QString& dir) {
+    PathRange r;
+    r.from = dir.endsWith('/') ? dir : dir + '/';
+    r.to = r.from;
+    r.to[r.to.size() - 1] = QChar('/' + 1);
+    return r;
+}
+
+// The files directly in dir share "dir/" as their folder, which SQL spells
+// rtrim(path, replace(path, '/', '')): rtrim() strips the trailing characters
+// that are not '/'. Indexed where folders are read (see migrateFolderIndex()).
+QString folderOf(const QString& dir) {
+    return dir.endsWith('/') ? dir : dir + '/';
+}
+
+} // namespace
+
+// SQLite serves WAL readers concurrently, but a few are plenty for lookups
+static constexpr int kReaderThreads = 4;
+
+// Sweeper pacing: a full pass over a large library takes a while, which is fine
+static constexpr int kSweepTickMs = 5000;
+static constexpr int kSweepBatch = 256;                     // paths checked per tick
+static constexpr qint64 kSweepRestMs = 6 * 60 * 60 * 1000;  // between passes
+
+TaggerStore::TaggerStore(QObject* parent) : QObject(parent) {
+    m_readPool.setMaxThreadCount(kReaderThreads);
+    connect(&m_writer, &StoreWriter::opened, this, &TaggerStore::opened);
+
+    m_sweepTimer.setInterval(kSweepTickMs);
+    connect(&m_sweepTimer, &QTimer::timeout, this, &TaggerStore::sweepStep);
+    connect(&m_writer, &StoreWriter::opened, this, [this](bool ok) {
+        if (!ok) return;
+        reloadTagDictionary();
+        m_sweepTimer.start();
+    });
+}
+
+TaggerStore::~TaggerStore() {
+    m_sweepTimer.stop();
+    m_readPool.clear();
+    m_readPool.waitForDone();
+    m_writer.stop(); // commits anything still queued
+    m_readPool.waitForDone(); // reads started by those commits (they find the store closed)
+}
+
+void TaggerStore::flush() {
+    m_writer.flush();
+}
+
+void TaggerStore::startRead(std::function<void()> job) {
+    struct Job : public QRunnable {
+        std::function<void()> fn;
+        explicit Job(std::function<void()> f) : fn(std::move(f)) {}
+        void run() override { fn(); }
     };
+    auto* job = new Job(std::move(job));
+    job->setAutoDelete(true);
+    m_readPool.start(job);
+}
+
+StoreConnection* TaggerStore::reader(const QString& key) {
+    if (!m_writer.waitUntilOpen()) return nullptr;
+
+    // Read-your-writes: only reads overlapping a queued write pay for a commit
+    if (!key.isEmpty() && m_writer.isPending(key)) m_writer.flush();
+
+    if (!m_readers.hasLocalData()) {
+        static std::atomic<int> serial{0};
+        auto* conn = new StoreConnection;
+        if (!conn->open(m_dbPath, QString("tagger-read-%1").arg(++serial), true)) {
+            delete conn;
+            conn = nullptr;
+        }
+        m_readers.setLocalData(conn); // null too: don't retry on every read
+    }
+    return m_readers.localData();
+}
+
+void TaggerStore::openOrCreate(const QString& dbPath) {
+    m_dbPath = dbPath;
+    m_writer.open(dbPath, &TaggerStore::createSchema);
+}
+
+// ---------- Schema ----------
+//
+// PRAGMA user_version is the number of migrations applied. Each runs once, in its
+// own transaction, on the writer thread before any other write. Append new
+// migrations; never edit one that has shipped.
+
+namespace {
+
+enum TagOwner { PathOwner = 0, HashOwner = 1 }; // file_tags.kind / tag_records.kind
+
+bool execAll(QSqlQuery& q, std::initializer_list<const char*> stmts) {
     for (auto s : stmts) {
         if (!q.exec(s)) {
-            qWarning() << "DB init failed:" << q.lastError().text() << "SQL:" << s;
+            qWarning() << "DB migration failed:" << q.lastError().text() << "SQL:" << s;
             return false;
         }
     }
     return true;
 }
 
-QString TaggerStore::tagsToJson(const QStringList& tags) {
-    QJsonArray arr;
-    for (const auto& t : tags) arr.append(t);
-    return QString::fromUtf8(QJsonDocument(arr).toJson(QJsonDocument::Compact));
+// Schema as it was before versioning; no-op on databases that already have it
+bool migrateBaseline(QSqlDatabase& db) {
+    QSqlQuery q(db);
+    return execAll(q, {
+        "CREATE TABLE IF NOT EXISTS workspaces(dir TEXT PRIMARY KEY, name TEXT NOT NULL, added_at INTEGER NOT NULL);",
+        "CREATE TABLE IF NOT EXISTS app_state(key TEXT PRIMARY KEY, value TEXT NOT NULL);",
+        "CREATE TABLE IF NOT EXISTS open_tabs(path TEXT PRIMARY KEY, opened_at INTEGER NOT NULL);",
+        "CREATE TABLE IF NOT EXISTS tags_by_path(path TEXT PRIMARY KEY, tags_json TEXT NOT NULL, updated_at INTEGER NOT NULL);",
+        "CREATE TABLE IF NOT EXISTS tags_by_hash(hash TEXT PRIMARY KEY, tags_json TEXT NOT NULL, updated_at INTEGER NOT NULL);",
+        "CREATE TABLE IF NOT EXISTS file_hash_cache(path TEXT PRIMARY KEY, size INTEGER NOT NULL, mtime INTEGER NOT NULL, hash TEXT NOT NULL, updated_at INTEGER NOT NULL);",
+        "CREATE TABLE IF NOT EXISTS thumb_placeholders(path TEXT PRIMARY KEY, color INTEGER NOT NULL, blurhash TEXT NOT NULL, updated_at INTEGER NOT NULL);",
+        "CREATE INDEX IF NOT EXISTS idx_tags_hash ON tags_by_hash(hash);",
+    });
 }
 
-QStringList TaggerStore::jsonToTags(const QString& json) {
+QStringList jsonToTags(const QString& json) {
     const auto doc = QJsonDocument::fromJson(json.toUtf8());
     if (!doc.isArray()) return {};
     QStringList out;
@@ -58,46 +159,338 @@ QStringList TaggerStore::jsonToTags(const QString& json) {
     return out;
 }
 
+// JSON tag arrays -> one row per (owner, tag). tag_records tells owners whose
+// list is empty apart from owners never tagged (those fall back to sidecars).
+bool migrateNormalizedTags(QSqlDatabase& db) {
+    QSqlQuery q(db);
+    if (!execAll(q, {
+        // Names are kept as typed (case-sensitive, like the editors); the NOCASE
+        // index serves case-insensitive lookups
+        "CREATE TABLE tags(id INTEGER PRIMARY KEY, name TEXT NOT NULL UNIQUE);",
+        "CREATE INDEX idx_tags_name_nocase ON tags(name COLLATE NOCASE);",
+        "CREATE TABLE tag_records(kind INTEGER NOT NULL, key TEXT NOT NULL, updated_at INTEGER NOT NULL, "
+        "PRIMARY KEY(kind, key)) WITHOUT ROWID;",
+        "CREATE TABLE file_tags(kind INTEGER NOT NULL, key TEXT NOT NULL, tag_id INTEGER NOT NULL REFERENCES tags(id), "
+        "pos INTEGER NOT NULL, PRIMARY KEY(kind, key, tag_id)) WITHOUT ROWID;",
+        "CREATE INDEX idx_file_tags_tag ON file_tags(tag_id, kind);",
+    })) return false;
+
+    QSqlQuery addTag(db), addRecord(db), addFileTag(db);
+    addTag.prepare("INSERT INTO tags(name) VALUES(?) ON CONFLICT(name) DO NOTHING;");
+    addRecord.prepare("INSERT OR REPLACE INTO tag_records(kind,key,updated_at) VALUES(?,?,?);");
+    addFileTag.prepare("INSERT OR IGNORE INTO file_tags(kind,key,tag_id,pos) SELECT ?,?,id,? FROM tags WHERE name=?;");
+
+    const struct { const char* select; TagOwner kind; } sources[] = {
+        {"SELECT path, tags_json, updated_at FROM tags_by_path;", PathOwner},
+        {"SELECT hash, tags_json, updated_at FROM tags_by_hash;", HashOwner},
+    };
+    for (const auto& src : sources) {
+        QSqlQuery rows(db);
+        rows.setForwardOnly(true);
+        if (!rows.exec(src.select)) {
+            qWarning() << "DB migration failed:" << rows.lastError().text();
+            return false;
+        }
+        while (rows.next()) {
+            const QString key = rows.value(0).toString();
+            const QStringList tags = jsonToTags(rows.value(1).toString());
+            addRecord.addBindValue(int(src.kind));
+            addRecord.addBindValue(key);
+            addRecord.addBindValue(rows.value(2));
+            bool ok = addRecord.exec();
+            for (int pos = 0; ok && pos < tags.size(); ++pos) {
+                addTag.addBindValue(tags[pos]);
+                addFileTag.addBindValue(int(src.kind));
+                addFileTag.addBindValue(key);
+                addFileTag.addBindValue(pos);
+                addFileTag.addBindValue(tags[pos]);
+                ok = addTag.exec() && addFileTag.exec();
+            }
+            if (!ok) {
+                qWarning() << "DB migration failed:" << addRecord.lastError().text()
+                           << addTag.lastError().text() << addFileTag.lastError().text();
+                return false;
+            }
+        }
+    }
+
+    return execAll(q, {"DROP TABLE tags_by_path;", "DROP TABLE tags_by_hash;"});
+}
+
+// Small rows keyed by a text primary key: WITHOUT ROWID stores each row once, in
+// the key's b-tree, instead of in a rowid table plus an index on the key
+// (halves their size and saves a lookup per read). Also drops the baseline's
+// idx_tags_hash, which duplicated a primary key (gone with its table in v2).
+bool migrateWithoutRowid(QSqlDatabase& db) {
+    QSqlQuery q(db);
+    return execAll(q, {
+        "DROP INDEX IF EXISTS idx_tags_hash;",
+
+        "CREATE TABLE workspaces_v3(dir TEXT PRIMARY KEY, name TEXT NOT NULL, added_at INTEGER NOT NULL) WITHOUT ROWID;",
+        "INSERT INTO workspaces_v3 SELECT dir, name, added_at FROM workspaces;",
+        "DROP TABLE workspaces;",
+        "ALTER TABLE workspaces_v3 RENAME TO workspaces;",
+
+        "CREATE TABLE app_state_v3(key TEXT PRIMARY KEY, value TEXT NOT NULL) WITHOUT ROWID;",
+        "INSERT INTO app_state_v3 SELECT key, value FROM app_state;",
+        "DROP TABLE app_state;",
+        "ALTER TABLE app_state_v3 RENAME TO app_state;",
+
+        "CREATE TABLE open_tabs_v3(path TEXT PRIMARY KEY, opened_at INTEGER NOT NULL) WITHOUT ROWID;",
+        "INSERT INTO open_tabs_v3 SELECT path, opened_at FROM open_tabs;",
+        "DROP TABLE open_tabs;",
+        "ALTER TABLE open_tabs_v3 RENAME TO open_tabs;",
+
+        "CREATE TABLE file_hash_cache_v3(path TEXT PRIMARY KEY, size INTEGER NOT NULL, mtime INTEGER NOT NULL, "
+        "hash TEXT NOT NULL, updated_at INTEGER NOT NULL) WITHOUT ROWID;",
+        "INSERT INTO file_hash_cache_v3 SELECT path, size, mtime, hash, updated_at FROM file_hash_cache;",
+        "DROP TABLE file_hash_cache;",
+        "ALTER TABLE file_hash_cache_v3 RENAME TO file_hash_cache;",
+
+        "CREATE TABLE thumb_placeholders_v3(path TEXT PRIMARY KEY, color INTEGER NOT NULL, blurhash TEXT NOT NULL, "
+        "updated_at INTEGER NOT NULL) WITHOUT ROWID;",
+        "INSERT INTO thumb_placeholders_v3 SELECT path, color, blurhash, updated_at FROM thumb_placeholders;",
+        "DROP TABLE thumb_placeholders;",
+        "ALTER TABLE thumb_placeholders_v3 RENAME TO thumb_placeholders;",
+    });
+}
+
+// FTS5 with the trigram tokenizer (SQLite 3.34+), which a system SQLite behind
+// the QSQLITE plugin may be built without or too old for
+bool hasTrigramFts(QSqlDatabase& db) {
+    QSqlQuery q(db);
+    if (!q.exec("CREATE VIRTUAL TABLE temp.trigram_probe USING fts5(x, tokenize='trigram case_sensitive 1');"))
+        return false;
+    q.exec("DROP TABLE temp.trigram_probe;");
+    return true;
+}
+
+// Every file seen by a folder scan, across workspaces, for global search (see
+// CatalogQuery). name_folded/tags_folded hold FoldedSearch::fold()ed text so SQL
+// can match exactly like the in-memory filter; catalog_fts indexes their
+// trigrams, kept in sync by triggers. Starts empty: folders are added as they load.
+// Without trigram FTS5 there is no catalog_fts and search scans the table: an
+// optional index must not keep the store (and everyone's tags) from opening.
+bool migrateCatalog(QSqlDatabase& db) {
+    QSqlQuery q(db);
+    if (!execAll(q, {
+        "CREATE TABLE catalog(id INTEGER PRIMARY KEY, path TEXT NOT NULL UNIQUE, dir TEXT NOT NULL, "
+        "name TEXT NOT NULL, name_folded TEXT NOT NULL, tags TEXT NOT NULL, tags_folded TEXT NOT NULL, "
+        "size INTEGER NOT NULL, mtime INTEGER NOT NULL, year INTEGER NOT NULL, kind INTEGER NOT NULL, "
+        "scanned_at INTEGER NOT NULL);",
+        "CREATE INDEX idx_catalog_dir ON catalog(dir);",
+        "CREATE INDEX idx_catalog_mtime ON catalog(mtime);",
+        "CREATE INDEX idx_catalog_year ON catalog(year);",
+        "CREATE INDEX idx_catalog_size ON catalog(size);",
+    })) return false;
+
+    if (!hasTrigramFts(db)) {
+        qWarning() << "SQLite has no trigram FTS5 tokenizer; global search scans the catalog";
+        return true;
+    }
+    return execAll(q, {
+        "CREATE VIRTUAL TABLE catalog_fts USING fts5(name_folded, tags_folded, content='catalog', "
+        "content_rowid='id', tokenize='trigram case_sensitive 1');",
+        "CREATE TRIGGER catalog_ai AFTER INSERT ON catalog BEGIN "
+        "INSERT INTO catalog_fts(rowid, name_folded, tags_folded) VALUES(new.id, new.name_folded, new.tags_folded); END;",
+        "CREATE TRIGGER catalog_ad AFTER DELETE ON catalog BEGIN "
+        "INSERT INTO catalog_fts(catalog_fts, rowid, name_folded, tags_folded) "
+        "VALUES('delete', old.id, old.name_folded, old.tags_folded); END;",
+        // Rescans rewrite every row; only real changes touch the index
+        "CREATE TRIGGER catalog_au AFTER UPDATE OF name_folded, tags_folded ON catalog "
+        "WHEN old.name_folded IS NOT new.name_folded OR old.tags_folded IS NOT new.tags_folded BEGIN "
+        "INSERT INTO catalog_fts(catalog_fts, rowid, name_folded, tags_folded) "
+        "VALUES('delete', old.id, old.name_folded, old.tags_folded); "
+        "INSERT INTO catalog_fts(rowid, name_folded, tags_folded) VALUES(new.id, new.name_folded, new.tags_folded); END;",
+    });
+}
+
+// Device/inode of each scanned file (see FileIdentity), to follow renames and
+// moves. One row per identity and per path.
+bool migrateFileIdentity(QSqlDatabase& db) {
+    QSqlQuery q(db);
+    return execAll(q, {
+        "CREATE TABLE file_identity(dev INTEGER NOT NULL, ino INTEGER NOT NULL, path TEXT NOT NULL, "
+        "size INTEGER NOT NULL, mtime INTEGER NOT NULL, PRIMARY KEY(dev, ino)) WITHOUT ROWID;",
+        "CREATE UNIQUE INDEX idx_file_identity_path ON file_identity(path);",
+    });
+}
+
+// mtime of each .ts/<name>.json sidecar as last imported (see SidecarImporter)
+bool migrateSidecarImports(QSqlDatabase& db) {
+    QSqlQuery q(db);
+    return execAll(q, {
+        "CREATE TABLE sidecar_imports(path TEXT PRIMARY KEY, mtime INTEGER NOT NULL) WITHOUT ROWID;",
+    });
+}
+
+// Path tags of one folder's files, not of its whole subtree (see folderOf())
+bool migrateFolderIndex(QSqlDatabase& db) {
+    QSqlQuery q(db);
+    return execAll(q, {
+        "CREATE INDEX idx_tag_records_folder ON tag_records(rtrim(key, replace(key, '/', ''))) WHERE kind = 0;",
+    });
+}
+
+// Placeholders remember the size and mtime of the file they were made from, so
+// an edited file gets a new one instead of a stale blur; they are read per
+// folder (see folderOf()). Old rows can't be checked and are dropped: they are
+// made again as thumbnails load.
+bool migratePlaceholderVersions(QSqlDatabase& db) {
+    QSqlQuery q(db);
+    return execAll(q, {
+        "DROP TABLE thumb_placeholders;",
+        "CREATE TABLE thumb_placeholders(path TEXT PRIMARY KEY, size INTEGER NOT NULL, mtime INTEGER NOT NULL, "
+        "color INTEGER NOT NULL, blurhash TEXT NOT NULL, updated_at INTEGER NOT NULL) WITHOUT ROWID;",
+        "CREATE INDEX idx_thumb_placeholders_folder ON thumb_placeholders(rtrim(path, replace(path, '/', '')));",
+    });
+}
+
+// Identities of one folder's files, for the check at each listing (see reattachMoved())
+bool migrateIdentityFolderIndex(QSqlDatabase& db) {
+    QSqlQuery q(db);
+    return execAll(q, {
+        "CREATE INDEX idx_file_identity_folder ON file_identity(rtrim(path, replace(path, '/', '')));",
+    });
+}
+
+// Tags and identities of missing files are tombstoned before they go, and a
+// workspace remembers its last full scan (see the sweeper)
+bool migrateMissingPaths(QSqlDatabase& db) {
+    QSqlQuery q(db);
+    return execAll(q, {
+        "CREATE TABLE missing_paths(path TEXT PRIMARY KEY, since INTEGER NOT NULL) WITHOUT ROWID;",
+        "ALTER TABLE workspaces ADD COLUMN scanned_at INTEGER NOT NULL DEFAULT 0;",
+    });
+}
+
+using Migration = bool (*)(QSqlDatabase&);
+const Migration kMigrations[] = {
+    migrateBaseline,            // 1
+    migrateNormalizedTags,      // 2
+    migrateWithoutRowid,        // 3
+    migrateCatalog,             // 4
+    migrateFileIdentity,        // 5
+    migrateSidecarImports,      // 6
+    migrateFolderIndex,         // 7
+    migratePlaceholderVersions, // 8
+    migrateIdentityFolderIndex, // 9
+    migrateMissingPaths,        // 10
+};
+
+} // namespace
+
+bool TaggerStore::createSchema(QSqlDatabase& db) {
+    QSqlQuery q(db);
+    if (!execAll(q, {
+        // Only takes effect on a new, empty file. 4 KiB matches the OS page and
+        // suits our short rows; larger pages mostly add write amplification.
+        "PRAGMA page_size=4096;",
+    })) return false;
+
+    // Deleted rows leave free pages that the writer gives back in idle slices
+    // (incremental_vacuum) instead of a full VACUUM. Free on a new file; an
+    // existing one is rebuilt once to switch modes (VACUUM needs no transaction).
+    if (!q.exec("PRAGMA auto_vacuum;") || !q.next()) return false;
+    const bool incremental = q.value(0).toInt() == 2;
+    q.finish();
+    if (!incremental && execAll(q, {"PRAGMA auto_vacuum=INCREMENTAL;"})
+        && q.exec("SELECT 1 FROM sqlite_master LIMIT 1;")) {
+        const bool empty = !q.next();
+        q.finish();
+        if (!empty) {
+            qCDebug(lcStore) << "DB switching to incremental auto-vacuum";
+            // Not fatal: the file just keeps its free pages
+            execAll(q, {"VACUUM;"});
+        }
+    }
+
+    if (!execAll(q, {
+        "PRAGMA journal_mode=WAL;",
+        "PRAGMA synchronous=NORMAL;", // WAL: durable up to the last checkpoint, never corrupt
+    })) return false;
+
+    if (!q.exec("PRAGMA user_version;") || !q.next()) return false;
+    const int version = q.value(0).toInt();
+    q.finish();
+    const int latest = int(std::size(kMigrations));
+    if (version > latest) {
+        qWarning() << "DB schema version" << version << "is newer than this build knows:" << latest;
+        return false;
+    }
+
+    for (int v = version; v < latest; ++v) {
+        db.transaction();
+        // PRAGMA takes no bound parameters; v is ours
+        if (!kMigrations[v](db) || !q.exec(QString("PRAGMA user_version=%1;").arg(v + 1))) {
+            qWarning() << "DB migration to version" << v + 1 << "failed, rolled back";
+            db.rollback();
+            return false;
+        }
+        if (!db.commit()) {
+            qWarning() << "DB migration commit failed:" << db.lastError().text();
+            db.rollback();
+            return false;
+        }
+        qCDebug(lcStore) << "DB migrated to version" << v + 1;
+    }
+
+    if (version < latest) {
+        // Fresh statistics for the new tables/indexes, and a short WAL again
+        // after what may have been a large rewrite
+        execAll(q, {"ANALYZE;", "PRAGMA wal_checkpoint(TRUNCATE);"});
+    }
+    return true;
+}
+
 // Workspaces
 QList<WorkspaceRec> TaggerStore::loadWorkspaces() {
     QList<WorkspaceRec> out;
-    QSqlQuery q(m_db);
-    q.exec("SELECT name, dir FROM workspaces ORDER BY added_at ASC;");
+    StoreConnection* conn = reader("workspaces");
+    if (!conn) return out;
+    StoreStatement q(*conn, "SELECT name, dir FROM workspaces ORDER BY added_at ASC;");
+    if (!q.exec()) return out;
     while (q.next()) out.push_back({q.value(0).toString(), q.value(1).toString()});
     return out;
 }
 
 void TaggerStore::upsertWorkspace(const QString& dir, const QString& name) {
-    QSqlQuery q(m_db);
-    q.prepare("INSERT INTO workspaces(dir,name,added_at) VALUES(?,?,?) "
-              "ON CONFLICT(dir) DO UPDATE SET name=excluded.name;");
-    q.addBindValue(dir);
-    q.addBindValue(name);
-    q.addBindValue(nowSecs());
-    q.exec();
+    m_writer.enqueue("INSERT INTO workspaces(dir,name,added_at) VALUES(?,?,?) "
+                     "ON CONFLICT(dir) DO UPDATE SET name=excluded.name;",
+                     {dir, name, nowSecs()}, {"workspaces"});
 }
 
 void TaggerStore::removeWorkspace(const QString& dir) {
-    QSqlQuery q(m_db);
-    q.prepare("DELETE FROM workspaces WHERE dir=?;");
-    q.addBindValue(dir);
-    q.exec();
+    const PathRange under = subtree(dir);
+
+    // Catalog, identities and placeholders come from scanning the folder and are
+    // dropped with it, unless another workspace still covers them. Tags and the
+    // hash cache stay in case the folder is added back.
+    m_writer.enqueue({
+        {"DELETE FROM workspaces WHERE dir=?;", {dir}},
+        {"DELETE FROM catalog WHERE path >= ? AND path < ? AND NOT EXISTS (SELECT 1 FROM workspaces w "
+         "WHERE catalog.path >= w.dir || '/' AND catalog.path < w.dir || '0');", {under.from, under.to}},
+        {"DELETE FROM file_identity WHERE path >= ? AND path < ? AND NOT EXISTS (SELECT 1 FROM workspaces w "
+         "WHERE file_identity.path >= w.dir || '/' AND file_identity.path < w.dir || '0');", {under.from, under.to}},
+        {"DELETE FROM thumb_placeholders WHERE path >= ? AND path < ? AND NOT EXISTS (SELECT 1 FROM workspaces w "
+         "WHERE thumb_placeholders.path >= w.dir || '/' AND thumb_placeholders.path < w.dir || '0');", {under.from, under.to}},
+        {"DELETE FROM missing_paths WHERE path >= ? AND path < ? AND NOT EXISTS (SELECT 1 FROM workspaces w "
+         "WHERE missing_paths.path >= w.dir || '/' AND missing_paths.path < w.dir || '0');", {under.from, under.to}},
+    }, {"workspaces", "catalog", "identity", "placeholders"});
 }
 
 // State
 void TaggerStore::setState(const QString& key, const QString& value) {
-    QSqlQuery q(m_db);
-    q.prepare("INSERT INTO app_state(key,value) VALUES(?,?) "
-              "ON CONFLICT(key) DO UPDATE SET value=excluded.value;");
-    q.addBindValue(key);
-    q.addBindValue(value);
-    q.exec();
+    m_writer.enqueue("INSERT INTO app_state(key,value) VALUES(?,?) "
+                     "ON CONFLICT(key) DO UPDATE SET value=excluded.value;",
+                     {key, value}, {"state:" + key});
 }
 
 std::optional<QString> TaggerStore::getState(const QString& key) {
-    QSqlQuery q(m_db);
-    q.prepare("SELECT value FROM app_state WHERE key=?;");
-    q.addBindValue(key);
+    StoreConnection* conn = reader("state:" + key);
+    if (!conn) return std::nullopt;
+    StoreStatement q(*conn, "SELECT value FROM app_state WHERE key=?;");
+    q.bind(key);
     if (!q.exec()) return std::nullopt;
     if (!q.next()) return std::nullopt;
     return q.value(0).toString();
@@ -106,72 +499,317 @@ std::optional<QString> TaggerStore::getState(const QString& key) {
 // Tabs
 QStringList TaggerStore::loadOpenTabs() {
     QStringList out;
-    QSqlQuery q(m_db);
-    q.exec("SELECT path FROM open_tabs ORDER BY opened_at ASC;");
+    StoreConnection* conn = reader("tabs");
+    if (!conn) return out;
+    StoreStatement q(*conn, "SELECT path FROM open_tabs ORDER BY opened_at ASC;");
+    if (!q.exec()) return out;
     while (q.next()) out << q.value(0).toString();
     return out;
 }
 void TaggerStore::addOpenTab(const QString& path) {
-    QSqlQuery q(m_db);
-    q.prepare("INSERT INTO open_tabs(path,opened_at) VALUES(?,?) "
-              "ON CONFLICT(path) DO UPDATE SET opened_at=excluded.opened_at;");
-    q.addBindValue(path);
-    q.addBindValue(nowSecs());
-    q.exec();
+    m_writer.enqueue("INSERT INTO open_tabs(path,opened_at) VALUES(?,?) "
+                     "ON CONFLICT(path) DO UPDATE SET opened_at=excluded.opened_at;",
+                     {path, nowSecs()}, {"tabs"});
 }
 void TaggerStore::removeOpenTab(const QString& path) {
-    QSqlQuery q(m_db);
-    q.prepare("DELETE FROM open_tabs WHERE path=?;");
-    q.addBindValue(path);
-    q.exec();
+    m_writer.enqueue("DELETE FROM open_tabs WHERE path=?;", {path}, {"tabs"});
 }
 void TaggerStore::clearOpenTabs() {
-    QSqlQuery q(m_db);
-    q.exec("DELETE FROM open_tabs;");
+    m_writer.enqueue("DELETE FROM open_tabs;", {}, {"tabs"});
 }
 
 // Tags
-std::optional<QStringList> TaggerStore::getTagsByPath(const QString& path) {
-    QSqlQuery q(m_db);
-    q.prepare("SELECT tags_json FROM tags_by_path WHERE path=?;");
-    q.addBindValue(path);
+std::optional<QStringList> TaggerStore::getTags(int kind, const QString& key) {
+    StoreConnection* conn = reader(tagsKey(kind, key));
+    if (!conn) return std::nullopt;
+    // No row: never tagged. One row with a NULL name: tagged, list empty.
+    StoreStatement q(*conn, "SELECT t.name FROM tag_records r "
+                            "LEFT JOIN file_tags f ON f.kind = r.kind AND f.key = r.key "
+                            "LEFT JOIN tags t ON t.id = f.tag_id "
+                            "WHERE r.kind = ? AND r.key = ? ORDER BY f.pos;");
+    q.bind(kind).bind(key);
     if (!q.exec() || !q.next()) return std::nullopt;
-    return jsonToTags(q.value(0).toString());
+    QStringList out;
+    do {
+        const QVariant name = q.value(0);
+        if (!name.isNull()) out << name.toString();
+    } while (q.next());
+    return out;
+}
+
+QStringList TaggerStore::normalizeTags(const QStringList& tags) {
+    QStringList out;
+    out.reserve(tags.size());
+    for (const QString& raw : tags) {
+        const QString tag = raw.trimmed();
+        if (!tag.isEmpty() && !out.contains(tag)) out << tag; // lists are short
+    }
+    return out;
+}
+
+QStringList TaggerStore::renamedTags(QStringList tags, const QString& from, const QString& to) {
+    const int at = tags.indexOf(from);
+    if (at < 0) return tags;
+    if (to.isEmpty() || tags.contains(to)) tags.removeAt(at);
+    else tags[at] = to;
+    return tags;
+}
+
+void TaggerStore::upsertTags(int kind, const QString& key, const QStringList& tags) {
+    QVector<StoreWriter::Step> steps;
+    QStringList keys;
+    tagSteps(kind, key, normalizeTags(tags), &steps, &keys);
+    m_writer.enqueue(steps, keys);
+}
+
+void TaggerStore::tagSteps(int kind, const QString& key, const QStringList& tags,
+                           QVector<StoreWriter::Step>* out, QStringList* keys) {
+    QVector<StoreWriter::Step>& steps = *out;
+    steps.push_back({"DELETE FROM file_tags WHERE kind = ? AND key = ?;", {kind, key}});
+    int pos = 0;
+    for (const QString& tag : tags) {
+        steps.push_back({"INSERT INTO tags(name) VALUES(?) ON CONFLICT(name) DO NOTHING;", {tag}});
+        steps.push_back({"INSERT OR IGNORE INTO file_tags(kind,key,tag_id,pos) SELECT ?,?,id,? FROM tags WHERE name = ?;",
+                         {kind, key, pos++, tag}});
+    }
+    steps.push_back({"INSERT INTO tag_records(kind,key,updated_at) VALUES(?,?,?) "
+                     "ON CONFLICT(kind,key) DO UPDATE SET updated_at=excluded.updated_at;",
+                     {kind, key, nowSecs()}});
+    *keys << tagsKey(kind, key);
+    if (kind == PathOwner) {
+        steps.push_back({"UPDATE catalog SET tags = ?, tags_folded = ? WHERE path = ?;",
+                         {tags.join('\n'), CatalogQuery::foldedTagLines(tags), key}});
+        *keys << QStringLiteral("catalog");
+    }
+}
+
+QString TaggerStore::tagsKey(int kind, const QString& key) {
+    return (kind == PathOwner ? QStringLiteral("tags:path:") : QStringLiteral("tags:hash:")) + key;
+}
+
+std::optional<QStringList> TaggerStore::getTagsByPath(const QString& path) {
+    return getTags(PathOwner, path);
 }
 
 std::optional<QStringList> TaggerStore::getTagsByHash(const QString& hash) {
-    QSqlQuery q(m_db);
-    q.prepare("SELECT tags_json FROM tags_by_hash WHERE hash=?;");
-    q.addBindValue(hash);
-    if (!q.exec() || !q.next()) return std::nullopt;
-    return jsonToTags(q.value(0).toString());
+    return getTags(HashOwner, hash);
 }
 
-void TaggerStore::upsertTagsByPath(const QString& path, const QStringList& tags) {
-    QSqlQuery q(m_db);
-    q.prepare("INSERT INTO tags_by_path(path,tags_json,updated_at) VALUES(?,?,?) "
-              "ON CONFLICT(path) DO UPDATE SET tags_json=excluded.tags_json, updated_at=excluded.updated_at;");
-    q.addBindValue(path);
-    q.addBindValue(tagsToJson(tags));
-    q.addBindValue(nowSecs());
-    q.exec();
+quint64 TaggerStore::upsertTagsByPath(const QString& path, const QStringList& tags, const QStringList& previous) {
+    return upsertTagsByPath(QVector<TagEdit>{{path, tags, previous}});
+}
+
+quint64 TaggerStore::upsertTagsByPath(const QVector<TagEdit>& raw) {
+    if (raw.isEmpty()) return 0;
+    const quint64 seq = ++m_editSeq;
+    // What is stored is also what the dictionary counts and views are told
+    QVector<TagEdit> edits;
+    edits.reserve(raw.size());
+    for (const TagEdit& e : raw) edits.push_back({e.path, normalizeTags(e.tags), normalizeTags(e.previous)});
+
+    QVector<StoreWriter::Step> steps;
+    QStringList keys;
+    for (const TagEdit& e : edits) tagSteps(PathOwner, e.path, e.tags, &steps, &keys);
+    // All or none, one transaction. Views and counts follow what was committed:
+    // a failed write leaves them showing the stored tags.
+    m_writer.enqueue(steps, keys, [this, edits, seq](bool committed) {
+        if (!committed) return;
+        for (const TagEdit& e : edits) {
+            m_tagDictionary.replace(e.previous, e.tags);
+            emit tagsChanged(e.path, e.tags, seq);
+        }
+    });
+    return seq;
+}
+
+void TaggerStore::copyPathTagsToHashes(const QVector<QPair<QString, QString>>& pathHashes) {
+    if (pathHashes.isEmpty()) return;
+    const qint64 now = nowSecs();
+    QVector<StoreWriter::Step> steps;
+    QStringList keys;
+    for (const auto& ph : pathHashes) {
+        const QString& path = ph.first;
+        const QString& hash = ph.second;
+        // Untagged files leave their hash's tags alone, like the details tabs do
+        steps.push_back({"DELETE FROM file_tags WHERE kind = 1 AND key = ? "
+                         "AND EXISTS (SELECT 1 FROM file_tags WHERE kind = 0 AND key = ?);", {hash, path}});
+        steps.push_back({"INSERT OR IGNORE INTO file_tags(kind,key,tag_id,pos) "
+                         "SELECT 1, ?, tag_id, pos FROM file_tags WHERE kind = 0 AND key = ?;", {hash, path}});
+        steps.push_back({"INSERT INTO tag_records(kind,key,updated_at) SELECT 1, ?, ? "
+                         "WHERE EXISTS (SELECT 1 FROM file_tags WHERE kind = 0 AND key = ?) "
+                         "ON CONFLICT(kind,key) DO UPDATE SET updated_at=excluded.updated_at;", {hash, now, path}});
+        keys << tagsKey(HashOwner, hash);
+    }
+    m_writer.enqueue(steps, keys);
 }
 
 void TaggerStore::upsertTagsByHash(const QString& hash, const QStringList& tags) {
-    QSqlQuery q(m_db);
-    q.prepare("INSERT INTO tags_by_hash(hash,tags_json,updated_at) VALUES(?,?,?) "
-              "ON CONFLICT(hash) DO UPDATE SET tags_json=excluded.tags_json, updated_at=excluded.updated_at;");
-    q.addBindValue(hash);
-    q.addBindValue(tagsToJson(tags));
-    q.addBindValue(nowSecs());
-    q.exec();
+    upsertTags(HashOwner, hash, tags);
+}
+
+QHash<QString, QStringList> TaggerStore::loadTagsInFolder(const QString& dirPath) {
+    QHash<QString, QStringList> out;
+    const QString folder = folderOf(dirPath);
+    StoreConnection* conn = reader();
+    if (!conn) return out;
+    // Read-your-writes: keys are per path, so look for any below the folder (a
+    // subfolder's pending edit costs a needless flush, no more)
+    if (m_writer.isPendingUnder(tagsKey(PathOwner, folder))) m_writer.flush();
+
+    StoreStatement q(*conn, "SELECT r.key, t.name FROM tag_records r "
+                            "LEFT JOIN file_tags f ON f.kind = r.kind AND f.key = r.key "
+                            "LEFT JOIN tags t ON t.id = f.tag_id "
+                            "WHERE r.kind = 0 AND rtrim(r.key, replace(r.key, '/', '')) = ? "
+                            "ORDER BY r.key, f.pos;");
+    q.bind(folder);
+    if (!q.exec()) return out;
+    while (q.next()) {
+        QStringList& tags = out[q.value(0).toString()];
+        const QVariant name = q.value(1);
+        if (!name.isNull()) tags << name.toString();
+    }
+    return out;
+}
+
+QStringList TaggerStore::pathsWithTag(const QString& tag) {
+    QStringList out;
+    flush(); // any path may be affected
+    StoreConnection* conn = reader();
+    if (!conn) return out;
+    StoreStatement q(*conn, "SELECT f.key FROM tags t JOIN file_tags f ON f.tag_id = t.id "
+                            "WHERE t.name = ? COLLATE NOCASE AND f.kind = ?;");
+    q.bind(tag.trimmed()).bind(int(PathOwner));
+    if (!q.exec()) return out;
+    while (q.next()) out << q.value(0).toString();
+    return out;
+}
+
+void TaggerStore::renameTag(const QString& from, const QString& to) {
+    if (!to.trimmed().isEmpty()) retag({from}, to.trimmed());
+}
+
+void TaggerStore::mergeTags(const QStringList& from, const QString& into) {
+    if (!into.trimmed().isEmpty()) retag(from, into.trimmed());
+}
+
+void TaggerStore::deleteTag(const QString& name) {
+    retag({name}, {});
+}
+
+void TaggerStore::retag(const QStringList& from, const QString& to) {
+    QStringList names;
+    for (const QString& f : from) {
+        if (!f.isEmpty() && f != to && !names.contains(f)) names << f;
+    }
+    if (names.isEmpty()) return;
+
+    // Set-based: a rename is one row of tags; a merge moves file_tags rows by the
+    // tag_id index. Only catalog rows need touching one by one.
+    startRead([this, names, to] {
+        StoreConnection* conn = reader();
+        if (!conn) return;
+        flush();
+
+        // Read-your-writes for every record that carries one of the names
+        QStringList keys{QStringLiteral("catalog")};
+        for (const QString& name : names) {
+            StoreStatement q(*conn, "SELECT f.kind, f.key FROM tags t JOIN file_tags f ON f.tag_id = t.id WHERE t.name = ?;");
+            q.bind(name);
+            if (!q.exec()) return;
+            while (q.next()) keys << tagsKey(q.value(0).toInt(), q.value(1).toString());
+        }
+
+        // Path tags of the files concerned, as the rename will leave them: their
+        // catalog tags_folded is rebuilt from these. Folding is Unicode, so not in
+        // SQL; and names match exactly while folded lines don't ("Cat", "cat").
+        QHash<QString, QStringList> renamed;
+        for (const QString& name : names) {
+            StoreStatement q(*conn, "SELECT f.key, t.name FROM file_tags f JOIN tags t ON t.id = f.tag_id "
+                                    "WHERE f.kind = 0 AND f.key IN (SELECT g.key FROM tags u JOIN file_tags g "
+                                    "ON g.tag_id = u.id WHERE u.name = ? AND g.kind = 0) ORDER BY f.key, f.pos;");
+            q.bind(name);
+            if (!q.exec()) return;
+            QHash<QString, QStringList> carrying;
+            while (q.next()) carrying[q.value(0).toString()] << q.value(1).toString();
+            for (auto it = carrying.cbegin(); it != carrying.cend(); ++it) {
+                if (!renamed.contains(it.key())) renamed.insert(it.key(), it.value());
+            }
+        }
+        for (QStringList& tags : renamed) {
+            for (const QString& name : names) tags = renamedTags(tags, name, to);
+        }
+
+        const qint64 now = nowSecs();
+        QVector<StoreWriter::Step> steps{
+            // Catalog paths to rebuild tags for, once the names are settled
+            {"CREATE TEMP TABLE IF NOT EXISTS retag(path TEXT PRIMARY KEY);", {}},
+            {"DELETE FROM temp.retag;", {}},
+        };
+        for (const QString& name : names) {
+            steps.push_back({"INSERT OR IGNORE INTO temp.retag(path) SELECT f.key FROM tags t "
+                             "JOIN file_tags f ON f.tag_id = t.id WHERE t.name = ? AND f.kind = 0;", {name}});
+            // Newer than the sidecars they may have come from (see importSidecarTags())
+            steps.push_back({"UPDATE tag_records SET updated_at = ? WHERE (kind, key) IN (SELECT f.kind, f.key "
+                             "FROM tags t JOIN file_tags f ON f.tag_id = t.id WHERE t.name = ?);", {now, name}});
+            if (!to.isEmpty()) {
+                // A plain rename when `to` is new; fails (ignored) when it exists, then merge
+                steps.push_back({"UPDATE OR IGNORE tags SET name = ? WHERE name = ?;", {to, name}});
+                steps.push_back({"UPDATE OR IGNORE file_tags SET tag_id = (SELECT id FROM tags WHERE name = ?) "
+                                 "WHERE tag_id = (SELECT id FROM tags WHERE name = ?);", {to, name}});
+            }
+            // Deleted, or files that had both names
+            steps.push_back({"DELETE FROM file_tags WHERE tag_id = (SELECT id FROM tags WHERE name = ?);", {name}});
+            steps.push_back({"DELETE FROM tags WHERE name = ?;", {name}});
+        }
+        steps.push_back({"UPDATE catalog SET tags = coalesce((SELECT group_concat(name, char(10)) FROM "
+                         "(SELECT t.name AS name FROM file_tags f JOIN tags t ON t.id = f.tag_id "
+                         "WHERE f.kind = 0 AND f.key = catalog.path ORDER BY f.pos)), '') "
+                         "WHERE path IN (SELECT path FROM temp.retag);", {}});
+        // Only where the rebuilt tags are the expected ones: an edit that got in
+        // between wrote its own folded lines
+        for (auto it = renamed.cbegin(); it != renamed.cend(); ++it) {
+            steps.push_back({"UPDATE catalog SET tags_folded = ? WHERE path = ? AND tags = ?;",
+                             {CatalogQuery::foldedTagLines(it.value()), it.key(), it.value().join('\n')}});
+        }
+        steps.push_back({"DELETE FROM temp.retag;", {}});
+
+        // Views and counts follow only a committed rename; a failed one leaves
+        // every name where it was
+        QElapsedTimer timer;
+        timer.start();
+        m_writer.enqueue(steps, keys, [this, names, to](bool committed) {
+            if (!committed) return;
+            reloadTagDictionary();
+            for (const QString& name : names) emit tagRenamed(name, to);
+        });
+        m_writer.flush();
+        qCDebug(lcStore) << "Retagged" << names << "->" << to << ":" << keys.size() - 1 << "records in"
+                         << timer.elapsed() << "ms";
+    });
+}
+
+void TaggerStore::reloadTagDictionary() {
+    startRead([this] {
+        StoreConnection* conn = reader();
+        if (!conn) return;
+        flush();
+        // Counts path records only: a file tagged by path and by hash is one use
+        StoreStatement q(*conn, "SELECT t.name, (SELECT count(*) FROM file_tags f "
+                                "WHERE f.tag_id = t.id AND f.kind = 0) FROM tags t;");
+        if (!q.exec()) return;
+        QVector<TagDictionary::Entry> entries;
+        while (q.next()) entries.push_back({q.value(0).toString(), q.value(1).toInt()});
+        m_tagDictionary.reset(entries);
+        qCDebug(lcStore) << "Tag dictionary:" << entries.size() << "names";
+    });
 }
 
 // Hash cache
 std::optional<QString> TaggerStore::getCachedHashIfValid(const QString& path, qint64 size, qint64 mtimeSecs) {
-    QSqlQuery q(m_db);
-    q.prepare("SELECT hash,size,mtime FROM file_hash_cache WHERE path=?;");
-    q.addBindValue(path);
+    StoreConnection* conn = reader("hash:" + path);
+    if (!conn) return std::nullopt;
+    StoreStatement q(*conn, "SELECT hash,size,mtime FROM file_hash_cache WHERE path=?;");
+    q.bind(path);
     if (!q.exec() || !q.next()) return std::nullopt;
     const qint64 sz = q.value(1).toLongLong();
     const qint64 mt = q.value(2).toLongLong();
@@ -180,14 +818,609 @@ std::optional<QString> TaggerStore::getCachedHashIfValid(const QString& path, qi
 }
 
 void TaggerStore::upsertHashCache(const QString& path, qint64 size, qint64 mtimeSecs, const QString& hash) {
-    QSqlQuery q(m_db);
-    q.prepare("INSERT INTO file_hash_cache(path,size,mtime,hash,updated_at) VALUES(?,?,?,?,?) "
-              "ON CONFLICT(path) DO UPDATE SET size=excluded.size, mtime=excluded.mtime, hash=excluded.hash, updated_at=excluded.updated_at;");
-    q.addBindValue(path);
-    q.addBindValue(size);
-    q.addBindValue(mtimeSecs);
-    q.addBindValue(hash);
-    q.addBindValue(nowSecs());
-    q.exec();
+    m_writer.enqueue("INSERT INTO file_hash_cache(path,size,mtime,hash,updated_at) VALUES(?,?,?,?,?) "
+                     "ON CONFLICT(path) DO UPDATE SET size=excluded.size, mtime=excluded.mtime, hash=excluded.hash, updated_at=excluded.updated_at;",
+                     {path, size, mtimeSecs, hash, nowSecs()}, {"hash:" + path});
+}
+
+// Placeholders
+QHash<QString, TaggerStore::StoredPlaceholder> TaggerStore::loadPlaceholdersInFolder(const QString& dirPath) {
+    QHash<QString, StoredPlaceholder> out;
+    StoreConnection* conn = reader("placeholders");
+    if (!conn) return out;
+    StoreStatement q(*conn, "SELECT path, size, mtime, color, blurhash FROM thumb_placeholders "
+                            "WHERE rtrim(path, replace(path, '/', '')) = ?;");
+    q.bind(folderOf(dirPath));
+    if (!q.exec()) return out;
+    while (q.next()) {
+        StoredPlaceholder sp;
+        sp.size = q.value(1).toLongLong();
+        sp.mtime = q.value(2).toLongLong();
+        sp.placeholder.color = QRgb(q.value(3).toUInt());
+        sp.placeholder.blurHash = q.value(4).toString();
+        out.insert(q.value(0).toString(), sp);
+    }
+    return out;
+}
+
+void TaggerStore::upsertPlaceholder(const QString& path, qint64 size, qint64 mtimeSecs,
+                                    const ThumbPlaceholder& placeholder) {
+    m_writer.enqueue("INSERT INTO thumb_placeholders(path,size,mtime,color,blurhash,updated_at) VALUES(?,?,?,?,?,?) "
+                     "ON CONFLICT(path) DO UPDATE SET size=excluded.size, mtime=excluded.mtime, "
+                     "color=excluded.color, blurhash=excluded.blurhash, updated_at=excluded.updated_at;",
+                     {path, size, mtimeSecs, qint64(placeholder.color), placeholder.blurHash, nowSecs()},
+                     {"placeholders"});
+}
+
+// Catalog
+void TaggerStore::upsertCatalog(const QString& dirPath, const QVector<FileItem>& items) {
+    static constexpr int kRowsPerWrite = 200; // keeps a rescan from holding up other writes
+    const qint64 scan = QDateTime::currentMSecsSinceEpoch();
+
+    // A row is only written when the listing differs from it, so revisiting an
+    // unchanged folder writes nothing but the presence check below. Files with a
+    // tag record keep the catalog's tags: tag writes maintain those, and the
+    // listing's copy may predate an edit still queued.
+    // The listed paths go to a temp table of the writer's connection: the
+    // presence check spans several writes, and needs no JSON1 from SQLite
+    QVector<StoreWriter::Step> steps{
+        {"CREATE TEMP TABLE IF NOT EXISTS listed(dir TEXT NOT NULL, path TEXT NOT NULL, PRIMARY KEY(dir, path));", {}},
+        {"DELETE FROM temp.listed WHERE dir = ?;", {dirPath}},
+    };
+    auto enqueue = [&] {
+        if (!steps.isEmpty()) m_writer.enqueue(steps, {QStringLiteral("catalog")});
+        steps.clear();
+    };
+    for (const FileItem& item : items) {
+        if (item.kind == FileKind::Directory) continue;
+        steps.push_back({"INSERT OR IGNORE INTO temp.listed(dir, path) VALUES(?, ?);", {dirPath, item.absolutePath}});
+        steps.push_back({"INSERT INTO catalog(path,dir,name,name_folded,tags,tags_folded,size,mtime,year,kind,scanned_at) "
+                         "VALUES(?,?,?,?,?,?,?,?,?,?,?) ON CONFLICT(path) DO UPDATE SET "
+                         "dir=excluded.dir, name=excluded.name, name_folded=excluded.name_folded, "
+                         "tags=CASE WHEN EXISTS (SELECT 1 FROM tag_records WHERE kind = 0 AND key = excluded.path) "
+                         "THEN tags ELSE excluded.tags END, "
+                         "tags_folded=CASE WHEN EXISTS (SELECT 1 FROM tag_records WHERE kind = 0 AND key = excluded.path) "
+                         "THEN tags_folded ELSE excluded.tags_folded END, "
+                         "size=excluded.size, mtime=excluded.mtime, year=excluded.year, kind=excluded.kind, "
+                         "scanned_at=excluded.scanned_at "
+                         "WHERE dir IS NOT excluded.dir OR name IS NOT excluded.name OR size IS NOT excluded.size "
+                         "OR mtime IS NOT excluded.mtime OR kind IS NOT excluded.kind OR (tags IS NOT excluded.tags "
+                         "AND NOT EXISTS (SELECT 1 FROM tag_records WHERE kind = 0 AND key = excluded.path));",
+                         {item.absolutePath, dirPath, item.fileName, FoldedSearch::fold(item.fileName),
+                          item.tags.join('\n'), CatalogQuery::foldedTagLines(item.tags), item.sizeBytes,
+                          item.modified.isValid() ? item.modified.toSecsSinceEpoch() : 0,
+                          item.modified.isValid() ? item.modified.date().year() : 0,
+                          int(item.kind), scan}});
+        if (steps.size() >= kRowsPerWrite * 2) enqueue();
+    }
+    // Files gone from the folder since its last scan
+    steps.push_back({"DELETE FROM catalog WHERE dir = ? AND path NOT IN (SELECT path FROM temp.listed WHERE dir = ?);",
+                     {dirPath, dirPath}});
+    steps.push_back({"DELETE FROM temp.listed WHERE dir = ?;", {dirPath}});
+    enqueue();
+}
+
+QVector<FileItem> TaggerStore::searchCatalog(const QueryMatcher::Plan& plan, int limit) {
+    QVector<FileItem> out;
+    StoreConnection* conn = reader(QStringLiteral("catalog"));
+    if (!conn) return out;
+
+    // Created by migration 4 only where SQLite has trigram FTS5
+    bool fts = false;
+    {
+        StoreStatement q(*conn, "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'catalog_fts';");
+        fts = q.exec() && q.next();
+    }
+
+    // Shape varies with the query, so not worth a cached statement
+    const CatalogQuery::Where where = CatalogQuery::compile(plan, fts);
+    QSqlQuery q(conn->database());
+    q.setForwardOnly(true);
+    q.prepare("SELECT c.path, c.name, c.tags, c.size, c.mtime, c.kind FROM catalog c WHERE " + where.sql +
+              " ORDER BY c.mtime DESC LIMIT ?;");
+    for (const QVariant& v : where.binds) q.addBindValue(v);
+    q.addBindValue(limit);
+    if (!q.exec()) {
+        qWarning() << "Catalog search failed:" << q.lastError().text() << "WHERE" << where.sql;
+        return out;
+    }
+    while (q.next()) {
+        FileItem item;
+        item.absolutePath = q.value(0).toString();
+        item.fileName = q.value(1).toString();
+        const QString tags = q.value(2).toString();
+        if (!tags.isEmpty()) item.tags = tags.split('\n');
+        item.sizeBytes = q.value(3).toLongLong();
+        item.modified = item.created = QDateTime::fromSecsSinceEpoch(q.value(4).toLongLong());
+        item.kind = FileKind(q.value(5).toInt());
+        out.push_back(std::move(item));
+    }
+    return out;
+}
+
+// Sidecars
+QHash<QString, qint64> TaggerStore::loadSidecarImportsUnder(const QString& dirPath) {
+    QHash<QString, qint64> out;
+    const PathRange under = subtree(dirPath);
+    StoreConnection* conn = reader("sidecars");
+    if (!conn) return out;
+    StoreStatement q(*conn, "SELECT path, mtime FROM sidecar_imports WHERE path >= ? AND path < ?;");
+    q.bind(under.from).bind(under.to);
+    if (!q.exec()) return out;
+    while (q.next()) out.insert(q.value(0).toString(), q.value(1).toLongLong());
+    return out;
+}
+
+int TaggerStore::importSidecarTags(const QVector<SidecarTags>& sidecars) {
+    if (sidecars.isEmpty()) return 0;
+    StoreConnection* conn = reader();
+    if (!conn) return 0;
+    flush(); // tag edits still queued count as newer
+
+    QVector<StoreWriter::Step> steps;
+    QStringList keys{QStringLiteral("sidecars"), QStringLiteral("catalog")};
+    QStringList applied; // paths
+    for (const SidecarTags& s : sidecars) {
+        steps.push_back({"INSERT INTO sidecar_imports(path,mtime) VALUES(?,?) "
+                         "ON CONFLICT(path) DO UPDATE SET mtime=excluded.mtime;", {s.sidecar, s.mtime}});
+        if (!s.tags) continue; // unreadable: remembered, so not parsed again until it changes
+        const QStringList tags = normalizeTags(*s.tags);
+
+        // Tags edited in the app after the sidecar was written win over it
+        StoreStatement q(*conn, "SELECT updated_at FROM tag_records WHERE kind = 0 AND key = ?;");
+        q.bind(s.path);
+        if (q.exec() && q.next() && q.value(0).toLongLong() >= s.mtime) continue;
+
+        // Same test in SQL as well, for an edit that lands before this write does
+        steps.push_back({"DELETE FROM file_tags WHERE kind = 0 AND key = ? AND NOT EXISTS "
+                         "(SELECT 1 FROM tag_records WHERE kind = 0 AND key = ? AND updated_at >= ?);",
+                         {s.path, s.path, s.mtime}});
+        int pos = 0;
+        for (const QString& tag : tags) {
+            steps.push_back({"INSERT INTO tags(name) VALUES(?) ON CONFLICT(name) DO NOTHING;", {tag}});
+            steps.push_back({"INSERT OR IGNORE INTO file_tags(kind,key,tag_id,pos) SELECT 0, ?, id, ? FROM tags "
+                             "WHERE name = ? AND NOT EXISTS "
+                             "(SELECT 1 FROM tag_records WHERE kind = 0 AND key = ? AND updated_at >= ?);",
+                             {s.path, pos++, tag, s.path, s.mtime}});
+        }
+        steps.push_back({"UPDATE catalog SET tags = ?, tags_folded = ? WHERE path = ? AND NOT EXISTS "
+                         "(SELECT 1 FROM tag_records WHERE kind = 0 AND key = ? AND updated_at >= ?);",
+                         {tags.join('\n'), CatalogQuery::foldedTagLines(tags), s.path, s.path, s.mtime}});
+        // Last: the guards above read it. Stamped with the sidecar's mtime, so a
+        // later edit here or a later change of the sidecar is newer.
+        steps.push_back({"INSERT INTO tag_records(kind,key,updated_at) VALUES(0,?,?) "
+                         "ON CONFLICT(kind,key) DO UPDATE SET updated_at=excluded.updated_at "
+                         "WHERE updated_at < excluded.updated_at;", {s.path, s.mtime}});
+        keys << tagsKey(PathOwner, s.path);
+        applied << s.path;
+    }
+    // One transaction for the lot; views follow once it is committed, with the
+    // tags actually stored: the guards above skip files edited in the app meanwhile
+    m_writer.enqueue(steps, keys, [this, applied](bool committed) {
+        if (!committed || applied.isEmpty()) return;
+        startRead([this, applied] {
+            const QHash<QString, QStringList> stored = loadPathTags(applied);
+            for (auto it = stored.cbegin(); it != stored.cend(); ++it) emit tagsChanged(it.key(), it.value(), 0);
+            reloadTagDictionary();
+        });
+    });
+    return applied.size();
+}
+
+QHash<QString, QStringList> TaggerStore::loadPathTags(const QStringList& paths) {
+    static constexpr int kPathsPerQuery = 500; // under the 999 binds older SQLite allows
+    QHash<QString, QStringList> out;
+    StoreConnection* conn = reader();
+    if (!conn) return out;
+    for (int i = 0; i < paths.size(); i += kPathsPerQuery) {
+        const QStringList chunk = paths.mid(i, kPathsPerQuery);
+        QString marks = QStringLiteral("?,").repeated(chunk.size());
+        marks.chop(1);
+        // Shape varies with the chunk size, so not a cached statement
+        QSqlQuery q(conn->database());
+        q.setForwardOnly(true);
+        q.prepare("SELECT r.key, t.name FROM tag_records r "
+                  "LEFT JOIN file_tags f ON f.kind = r.kind AND f.key = r.key "
+                  "LEFT JOIN tags t ON t.id = f.tag_id "
+                  "WHERE r.kind = 0 AND r.key IN (" + marks + ") ORDER BY r.key, f.pos;");
+        for (const QString& p : chunk) q.addBindValue(p);
+        if (!q.exec()) {
+            qWarning() << "Loading tags failed:" << q.lastError().text();
+            continue;
+        }
+        while (q.next()) {
+            QStringList& tags = out[q.value(0).toString()]; // tagged, possibly with nothing
+            if (!q.value(1).isNull()) tags << q.value(1).toString();
+        }
+    }
+    return out;
 }
 
+// Identity
+int TaggerStore::reattachMoved(const QString& dirPath, const QVector<ScannedFile>& files) {
+    static constexpr int kFilesPerWrite = 200;
+
+    StoreConnection* conn = reader(QStringLiteral("identity"));
+    if (!conn) return 0;
+
+    // What this folder's files looked like at its last scan: unchanged ones need
+    // no lookup, and no stat() for their identity either
+    struct Known { FileIdentity id; qint64 size; qint64 mtime; };
+    QHash<QString, Known> known;
+    {
+        StoreStatement q(*conn, "SELECT path, dev, ino, size, mtime FROM file_identity "
+                                "WHERE rtrim(path, replace(path, '/', '')) = ?;");
+        q.bind(folderOf(dirPath));
+        if (q.exec()) {
+            while (q.next()) {
+                known.insert(q.value(0).toString(),
+                             {{quint64(q.value(1).toLongLong()), quint64(q.value(2).toLongLong())},
+                              q.value(3).toLongLong(), q.value(4).toLongLong()});
+            }
+        }
+    }
+
+    int moved = 0;
+    QVector<StoreWriter::Step> steps;
+    QStringList keys;
+    auto enqueue = [&] {
+        if (steps.isEmpty()) return;
+        keys << QStringLiteral("identity") << QStringLiteral("catalog");
+        m_writer.enqueue(steps, keys);
+        steps.clear();
+        keys.clear();
+    };
+
+    for (const ScannedFile& f : files) {
+        // Same size and mtime at the same path: the same file
+        const auto k = known.constFind(f.path);
+        if (k != known.constEnd() && k->size == f.size && k->mtime == f.mtime) continue;
+
+        const FileIdentity id = FileIdentity::of(f.path);
+        if (!id.isValid()) continue;
+        const qint64 dev = qint64(id.device), ino = qint64(id.inode);
+        if (k == known.constEnd() || k->id != id) {
+            // New here: the same file somewhere else before? Size and mtime guard against
+            // a reused inode; the old path must be gone (not a hard link).
+            StoreStatement q(*conn, "SELECT path, size, mtime FROM file_identity WHERE dev = ? AND ino = ?;");
+            q.bind(dev).bind(ino);
+            if (q.exec() && q.next()) {
+                const QString from = q.value(0).toString();
+                if (from != f.path && q.value(1).toLongLong() == f.size && q.value(2).toLongLong() == f.mtime
+                    && !QFileInfo::exists(from)) {
+                    moveSteps(from, f.path, &steps);
+                    keys << tagsKey(PathOwner, from) << tagsKey(PathOwner, f.path)
+                         << "hash:" + from << "hash:" + f.path
+                         << QStringLiteral("placeholders") << QStringLiteral("tabs");
+                    ++moved;
+                }
+            }
+        }
+
+        steps.push_back({"DELETE FROM file_identity WHERE path = ? AND NOT (dev = ? AND ino = ?);", {f.path, dev, ino}});
+        steps.push_back({"INSERT INTO file_identity(dev,ino,path,size,mtime) VALUES(?,?,?,?,?) "
+                         "ON CONFLICT(dev,ino) DO UPDATE SET path=excluded.path, size=excluded.size, mtime=excluded.mtime;",
+                         {dev, ino, f.path, f.size, f.mtime}});
+        if (steps.size() >= kFilesPerWrite * 2) enqueue();
+    }
+    enqueue();
+
+    if (moved) qCDebug(lcStore) << "Reattached" << moved << "moved files under" << dirPath;
+    return moved;
+}
+
+void TaggerStore::moveSteps(const QString& from, const QString& to, QVector<StoreWriter::Step>* steps) {
+    // Path-keyed tags follow the file unless the new path has a record of its own
+    steps->push_back({"UPDATE file_tags SET key = ? WHERE kind = 0 AND key = ? "
+                      "AND NOT EXISTS (SELECT 1 FROM tag_records WHERE kind = 0 AND key = ?);", {to, from, to}});
+    steps->push_back({"UPDATE tag_records SET key = ? WHERE kind = 0 AND key = ? "
+                      "AND NOT EXISTS (SELECT 1 FROM tag_records WHERE kind = 0 AND key = ?);", {to, from, to}});
+    steps->push_back({"DELETE FROM file_tags WHERE kind = 0 AND key = ?;", {from}});
+    steps->push_back({"DELETE FROM tag_records WHERE kind = 0 AND key = ?;", {from}});
+    // Same size and mtime, so the cached hash is still right
+    steps->push_back({"UPDATE OR REPLACE file_hash_cache SET path = ? WHERE path = ?;", {to, from}});
+    steps->push_back({"UPDATE OR REPLACE thumb_placeholders SET path = ? WHERE path = ?;", {to, from}});
+    steps->push_back({"UPDATE OR IGNORE open_tabs SET path = ? WHERE path = ?;", {to, from}});
+    steps->push_back({"DELETE FROM catalog WHERE path = ?;", {from}}); // the scan adds the new path
+    steps->push_back({"DELETE FROM missing_paths WHERE path = ?;", {from}});
+}
+
+// ---------- Garbage collection ----------
+//
+// Path-keyed rows outlive their files: nothing tells the store when a file is
+// deleted outside the app. The sweeper walks each table below by primary key,
+// kSweepBatch paths per tick, and deals with the paths that are gone:
+//  - a path is only gone if the volume it was on is there: the deepest folder of
+//    it that still exists, up to its workspace root (or its own folder, outside
+//    workspaces), must be on the device file_identity recorded for the file. An
+//    unplugged drive or an empty mount point costs nothing;
+//  - derived rows (hash cache, placeholders, catalog...) are dropped right away;
+//  - tags and identities are what follows a file that was moved (see
+//    reattachMoved()), and a move out of a folder is seen long before the folder
+//    it went to is listed. They are tombstoned in missing_paths instead, and
+//    pruned once kMissingGraceSecs passed and, in a workspace, a full scan of it
+//    since then had its chance to find the file (see scanWorkspace()). A path
+//    without a recorded identity can't be checked and keeps its tags.
+// Hash-keyed tags are content, not location, and are never swept. The free
+// pages this leaves are given back by the writer while idle (StoreWriter).
+
+namespace {
+
+// Tombstoned tags and identities are kept this long
+constexpr qint64 kMissingGraceSecs = 30 * 24 * 60 * 60;
+
+struct SweptTable {
+    const char* name;
+    // Keys after ?, in order, at most ? of them: path, since when it is missing
+    // (NULL: not tombstoned) and its recorded device (NULL: unknown)
+    const char* select;
+    bool kept; // tombstoned first (tags, identities)
+    QVector<StoreWriter::Step> (*remove)(const QString& path);
+    QString (*key)(const QString& path); // for read-your-writes
+};
+
+// A missing path's tags, identity and tombstone, all at once
+QVector<StoreWriter::Step> pruneMissing(const QString& p) {
+    return {{"DELETE FROM file_tags WHERE kind = 0 AND key = ?;", {p}},
+            {"DELETE FROM tag_records WHERE kind = 0 AND key = ?;", {p}},
+            {"DELETE FROM file_identity WHERE path = ?;", {p}},
+            {"DELETE FROM missing_paths WHERE path = ?;", {p}}};
+}
+
+const SweptTable kSwept[] = {
+    {"tag_records",
+     "SELECT r.key, m.since, i.dev FROM tag_records r LEFT JOIN missing_paths m ON m.path = r.key "
+     "LEFT JOIN file_identity i ON i.path = r.key WHERE r.kind = 0 AND r.key > ? ORDER BY r.key LIMIT ?;",
+     true, pruneMissing,
+     [](const QString& p) -> QString { return QStringLiteral("tags:path:") + p; }},
+    {"file_hash_cache",
+     "SELECT h.path, NULL, i.dev FROM file_hash_cache h LEFT JOIN file_identity i ON i.path = h.path "
+     "WHERE h.path > ? ORDER BY h.path LIMIT ?;",
+     false,
+     [](const QString& p) -> QVector<StoreWriter::Step> {
+         return {{"DELETE FROM file_hash_cache WHERE path = ?;", {p}}};
+     },
+     [](const QString& p) -> QString { return QStringLiteral("hash:") + p; }},
+    {"thumb_placeholders",
+     "SELECT t.path, NULL, i.dev FROM thumb_placeholders t LEFT JOIN file_identity i ON i.path = t.path "
+     "WHERE t.path > ? ORDER BY t.path LIMIT ?;",
+     false,
+     [](const QString& p) -> QVector<StoreWriter::Step> {
+         return {{"DELETE FROM thumb_placeholders WHERE path = ?;", {p}}};
+     },
+     [](const QString&) -> QString { return QStringLiteral("placeholders"); }},
+    {"open_tabs",
+     "SELECT o.path, NULL, i.dev FROM open_tabs o LEFT JOIN file_identity i ON i.path = o.path "
+     "WHERE o.path > ? ORDER BY o.path LIMIT ?;",
+     false,
+     [](const QString& p) -> QVector<StoreWriter::Step> {
+         return {{"DELETE FROM open_tabs WHERE path = ?;", {p}}};
+     },
+     [](const QString&) -> QString { return QStringLiteral("tabs"); }},
+    {"catalog",
+     "SELECT c.path, NULL, i.dev FROM catalog c LEFT JOIN file_identity i ON i.path = c.path "
+     "WHERE c.path > ? ORDER BY c.path LIMIT ?;",
+     false,
+     [](const QString& p) -> QVector<StoreWriter::Step> {
+         return {{"DELETE FROM catalog WHERE path = ?;", {p}}};
+     },
+     [](const QString&) -> QString { return QStringLiteral("catalog"); }},
+    {"file_identity",
+     "SELECT i.path, m.since, i.dev FROM file_identity i LEFT JOIN missing_paths m ON m.path = i.path "
+     "WHERE i.path > ? ORDER BY i.path LIMIT ?;",
+     true, pruneMissing,
+     [](const QString&) -> QString { return QStringLiteral("identity"); }},
+    {"sidecar_imports",
+     "SELECT path, NULL, NULL FROM sidecar_imports WHERE path > ? ORDER BY path LIMIT ?;",
+     false,
+     [](const QString& p) -> QVector<StoreWriter::Step> {
+         return {{"DELETE FROM sidecar_imports WHERE path = ?;", {p}}};
+     },
+     [](const QString&) -> QString { return QStringLiteral("sidecars"); }},
+};
+
+} // namespace
+
+void TaggerStore::sweepStep() {
+    // One batch at a time, and only while nothing else is going on
+    if (m_sweeping.exchange(true)) return;
+    if (!m_sweep.restUntil.hasExpired() || m_writer.stats().queueDepth > 0
+        || m_readPool.activeThreadCount() > 0) {
+        m_sweeping = false;
+        return;
+    }
+    startRead([this] {
+        sweepBatch();
+        m_sweeping = false;
+    });
+}
+
+void TaggerStore::sweepBatch() {
+    StoreConnection* conn = reader();
+    if (!conn) return;
+    SweepState& s = m_sweep;
+    const int tableCount = int(std::size(kSwept));
+    if (s.pruned.size() != tableCount) s.pruned = QVector<int>(tableCount, 0);
+    const SweptTable& table = kSwept[s.table];
+
+    struct Row {
+        QString path;
+        qint64 missingSince; // -1: not tombstoned
+        quint64 device;      // 0: unknown
+    };
+    QVector<Row> rows;
+    {
+        StoreStatement q(*conn, table.select);
+        q.bind(s.after).bind(kSweepBatch);
+        if (!q.exec()) return;
+        while (q.next()) {
+            rows.push_back({q.value(0).toString(), q.value(1).isNull() ? -1 : q.value(1).toLongLong(),
+                            quint64(q.value(2).toLongLong())});
+        }
+    }
+
+    struct Workspace {
+        QString dir;
+        qint64 scannedAt;
+    };
+    QVector<Workspace> workspaces;
+    {
+        StoreStatement q(*conn, "SELECT dir, scanned_at FROM workspaces;");
+        if (q.exec()) {
+            while (q.next()) workspaces.push_back({q.value(0).toString(), q.value(1).toLongLong()});
+        }
+    }
+
+    // Device of the deepest folder above path that exists, up to root; 0 if none does
+    QHash<QString, quint64> devices; // this batch
+    auto deviceAbove = [&devices](const QString& path, const QString& root) -> quint64 {
+        QString dir = QFileInfo(path).path();
+        forever {
+            const auto known = devices.constFind(dir);
+            if (known != devices.constEnd()) return known.value();
+            const FileIdentity id = FileIdentity::of(dir);
+            if (id.isValid()) {
+                devices.insert(dir, id.device);
+                return id.device;
+            }
+            const QString parent = QFileInfo(dir).path();
+            if (dir.size() <= root.size() || parent == dir) return 0;
+            dir = parent;
+        }
+    };
+
+    const qint64 now = nowSecs();
+    QVector<StoreWriter::Step> steps;
+    QStringList keys;
+    for (const Row& r : rows) {
+        if (QFileInfo::exists(r.path)) {
+            // Back again (a drive plugged in, a file restored)
+            if (r.missingSince >= 0) {
+                steps.push_back({"DELETE FROM missing_paths WHERE path = ?;", {r.path}});
+                keys << QStringLiteral("identity");
+            }
+            continue;
+        }
+
+        const Workspace* ws = nullptr;
+        for (const Workspace& w : workspaces) {
+            if (r.path.startsWith(w.dir + '/') && (!ws || w.dir.size() > ws->dir.size())) ws = &w;
+        }
+        const quint64 device = deviceAbove(r.path, ws ? ws->dir : QFileInfo(r.path).path());
+        if (!device) continue;                        // its volume is not there
+        if (r.device && device != r.device) continue; // another volume is mounted there
+        if (!r.device && table.kept) continue;        // can't tell
+
+        if (table.kept) {
+            if (r.missingSince < 0) {
+                steps.push_back({"INSERT OR IGNORE INTO missing_paths(path, since) VALUES(?, ?);", {r.path, now}});
+                keys << QStringLiteral("identity");
+                ++s.tombstoned;
+                continue;
+            }
+            if (now - r.missingSince < kMissingGraceSecs || (ws && ws->scannedAt <= r.missingSince)) continue;
+        }
+        steps += table.remove(r.path);
+        keys << table.key(r.path);
+        if (table.kept) keys << tagsKey(PathOwner, r.path) << QStringLiteral("identity");
+        ++s.pruned[s.table];
+    }
+    if (!steps.isEmpty()) m_writer.enqueue(steps, keys);
+    s.checked += rows.size();
+
+    if (rows.size() == kSweepBatch) {
+        s.after = rows.last().path;
+        return;
+    }
+
+    // This table is done
+    s.after.clear();
+    if (++s.table < tableCount) return;
+
+    // Pass complete: tag names nothing uses anymore go too
+    m_writer.enqueue("DELETE FROM tags WHERE NOT EXISTS (SELECT 1 FROM file_tags f WHERE f.tag_id = tags.id);",
+                     {}, {"tags"});
+
+    // Tombstones past their grace period get a full scan of their workspace, if
+    // none ran since they were set; the next pass prunes what it did not find
+    QStringList toScan;
+    {
+        StoreStatement q(*conn, "SELECT w.dir FROM workspaces w WHERE EXISTS (SELECT 1 FROM missing_paths m "
+                                "WHERE m.path >= w.dir || '/' AND m.path < w.dir || '0' "
+                                "AND m.since <= ? AND m.since >= w.scanned_at);");
+        q.bind(now - kMissingGraceSecs);
+        if (q.exec()) {
+            while (q.next()) toScan << q.value(0).toString();
+        }
+    }
+    int found = 0;
+    for (const QString& dir : toScan) found += scanWorkspace(dir);
+
+    if (lcStore().isDebugEnabled()) {
+        QStringList counts;
+        int total = 0;
+        for (int i = 0; i < tableCount; ++i) {
+            counts << QString("%1 %2").arg(kSwept[i].name).arg(s.pruned[i]);
+            total += s.pruned[i];
+        }
+        qCDebug(lcStore).noquote()
+            << QString("sweep: checked %1 paths, pruned %2 (%3), %4 newly missing, %5 found in %6 "
+                       "workspace scan(s), vacuumed %7 KiB so far")
+                   .arg(s.checked)
+                   .arg(total)
+                   .arg(counts.join(", "))
+                   .arg(s.tombstoned)
+                   .arg(found)
+                   .arg(toScan.size())
+                   .arg(m_writer.stats().vacuumedBytes / 1024);
+    }
+    s = SweepState();
+    s.restUntil.setRemainingTime(kSweepRestMs);
+}
+
+int TaggerStore::scanWorkspace(const QString& root) {
+    StoreConnection* conn = reader(QStringLiteral("identity"));
+    if (!conn || !FileIdentity::of(root).isValid()) return 0; // not there: no scan
+
+    // Identities of the files missing under root
+    QSet<QPair<quint64, quint64>> wanted;
+    {
+        const PathRange under = subtree(root);
+        StoreStatement q(*conn, "SELECT i.dev, i.ino FROM missing_paths m JOIN file_identity i ON i.path = m.path "
+                                "WHERE m.path >= ? AND m.path < ?;");
+        q.bind(under.from).bind(under.to);
+        if (q.exec()) {
+            while (q.next()) wanted.insert({quint64(q.value(0).toLongLong()), quint64(q.value(1).toLongLong())});
+        }
+    }
+
+    // Folders as listings see them (hidden ones skipped); a stat() only for files
+    // whose inode is one of those wanted, then the same checks as a listing
+    QElapsedTimer timer;
+    timer.start();
+    int found = 0;
+    int folders = 0;
+    QStringList dirs;
+    if (!wanted.isEmpty()) dirs << root;
+    while (!dirs.isEmpty()) {
+        const QString dir = dirs.takeLast();
+        const QString base = folderOf(dir);
+        QVector<ScannedFile> candidates;
+        for (const FileIdentity::Entry& e : FileIdentity::list(dir)) {
+            if (e.name.startsWith('.')) continue;
+            if (e.isDir) {
+                dirs << base + e.name;
+            } else if (wanted.contains({e.id.device, e.id.inode})) {
+                const QFileInfo fi(base + e.name);
+                candidates.push_back({fi.absoluteFilePath(), fi.size(), fi.lastModified().toSecsSinceEpoch()});
+            }
+        }
+        if (!candidates.isEmpty()) found += reattachMoved(dir, candidates);
+        ++folders;
+    }
+
+    m_writer.enqueue("UPDATE workspaces SET scanned_at = ? WHERE dir = ?;", {nowSecs(), root}, {"workspaces"});
+    qCDebug(lcStore) << "Scanned" << root << "for" << wanted.size() << "missing files:" << folders << "folders,"
+                     << found << "found in" << timer.elapsed() << "ms";
+    return found;
+}
@@ -3,23 +3,72 @@
 
 #pragma once
 #include <QObject>
+#include <QDeadlineTimer>
+#include <QMetaObject>
+#include <QPointer>
 #include <QStringList>
-#include <QSqlDatabase>
+#include <QHash>
+#include <QThreadPool>
+#include <QThreadStorage>
+#include <QTimer>
+#include <atomic>
+#include <functional>
 #include <optional>
+#include <utility>
+#include "fileitem.h"
+#include "querymatcher.h"
+#include "storeconnection.h"
+#include "storewriter.h"
+#include "tagdictionary.h"
 
 struct WorkspaceRec { QString name; QString dir; };
 
+// No SQL runs on the calling thread of a write, and none should run on the GUI
+// thread at all:
+//  - writes are queued and committed in batches by the writer thread, which owns
+//    the only read-write connection (see StoreWriter);
+//  - reads run on whatever thread calls them, each thread with its own read-only
+//    connection, and still see queued writes. They block, so the GUI thread goes
+//    through read(), which runs them on the store's reader pool.
+// Once open, a sweeper walks the path-keyed tables in small batches while the
+// store is quiet and drops rows of files that no longer exist; tags of a missing
+// file are kept a grace period first, in case it turns up elsewhere (see the
+// notes above kSwept in the .cpp).
 class TaggerStore : public QObject {
     Q_OBJECT
 public:
     explicit TaggerStore(QObject* parent = nullptr);
+    ~TaggerStore() override;
 
-    bool openOrCreate(const QString& dbPath);
+    // Asynchronous: creates the schema on the writer thread, then emits opened().
+    // Reads issued before that wait for it (on their own thread).
+    void openOrCreate(const QString& dbPath);
+
+    // Returns once everything queued is on disk
+    void flush();
+
+    // Runs query() on the reader pool, then done(result) on context's thread,
+    // unless context was destroyed meanwhile. E.g.
+    //   store->read(this, [store]{ return store->loadOpenTabs(); },
+    //               [this](const QStringList& tabs){ ... });
+    template <typename Query, typename Done>
+    void read(QObject* context, Query query, Done done) {
+        QPointer<QObject> ctx(context);
+        startRead([ctx, query = std::move(query), done = std::move(done)]() mutable {
+            if (!ctx) return;
+            auto result = query();
+            QMetaObject::invokeMethod(ctx, [ctx, done = std::move(done), result = std::move(result)]() mutable {
+                if (ctx) done(std::move(result));
+            }, Qt::QueuedConnection);
+        });
+    }
+
+    // Reads (load*/get*) block until the database answers; writes only queue.
 
     // Workspaces
     QList<WorkspaceRec> loadWorkspaces();
     void upsertWorkspace(const QString& dir, const QString& name);
-    void removeWorkspace(const QString& dir);
+    void removeWorkspace(const QString& dir); // and what was derived from scanning it; tags stay
 
     // App state
     void setState(const QString& key, const QString& value);
@@ -32,20 +81,158 @@ public:
     void clearOpenTabs();
 
     // Tags
+    // As tag lists are stored: trimmed, no empty names, each name once (first
+    // position kept). The upserts apply it themselves; tagsChanged() carries the
+    // result.
+    static QStringList normalizeTags(const QStringList& tags);
+    // tags as tagRenamed(from, to) leaves them: `from` becomes `to` in place, or
+    // goes if `to` is empty or already there
+    static QStringList renamedTags(QStringList tags, const QString& from, const QString& to);
     std::optional<QStringList> getTagsByPath(const QString& path);
     std::optional<QStringList> getTagsByHash(const QString& hash);
-    void upsertTagsByPath(const QString& path, const QStringList& tags);
+    // previous: the list being replaced, as the caller has it; keeps the
+    // dictionary's usage counts current without a read. Returns the write's
+    // sequence number, which tagsChanged() carries once it is committed.
+    quint64 upsertTagsByPath(const QString& path, const QStringList& tags, const QStringList& previous);
     void upsertTagsByHash(const QString& hash, const QStringList& tags);
 
+    // Many files at once (bulk tagging): one write, one transaction
+    struct TagEdit {
+        QString path;
+        QStringList tags;
+        QStringList previous; // see upsertTagsByPath()
+    };
+    quint64 upsertTagsByPath(const QVector<TagEdit>& edits); // one sequence number for all
+    // For (path, hash) pairs: the hash's tags become the path's, as the details
+    // tabs do after hashing one file. Files without tags are skipped. One write.
+    void copyPathTagsToHashes(const QVector<QPair<QString, QString>>& pathHashes);
+    // Tags of the files directly in dirPath, keyed by absolute path (one index
+    // range; subfolders are not read)
+    QHash<QString, QStringList> loadTagsInFolder(const QString& dirPath);
+    // Files carrying tag, case-insensitively for ASCII (an index seek, no scan)
+    QStringList pathsWithTag(const QString& tag);
+
     // Hash cache
     std::optional<QString> getCachedHashIfValid(const QString& path, qint64 size, qint64 mtimeSecs);
     void upsertHashCache(const QString& path, qint64 size, qint64 mtimeSecs, const QString& hash);
 
+    // Thumbnail placeholders, each made from the file at the size and mtime stored
+    // with it; one that no longer matches the file is stale
+    struct StoredPlaceholder {
+        ThumbPlaceholder placeholder;
+        qint64 size = 0;
+        qint64 mtime = 0; // seconds
+    };
+    // Those of the files directly in dirPath, keyed by absolute path (one index range)
+    QHash<QString, StoredPlaceholder> loadPlaceholdersInFolder(const QString& dirPath);
+    void upsertPlaceholder(const QString& path, qint64 size, qint64 mtimeSecs, const ThumbPlaceholder& placeholder);
+
+    // Catalog of every scanned file, all workspaces (global search)
+    // Records a scan of dirPath: its files as listed, dropping ones no longer there.
+    void upsertCatalog(const QString& dirPath, const QVector<FileItem>& items);
+    // Newest first; items carry path, name, tags, size, mtime and kind only
+    QVector<FileItem> searchCatalog(const QueryMatcher::Plan& plan, int limit);
+
+    // Library-wide, path and hash records alike, each one write (one transaction).
+    // Asynchronous: tagRenamed() once committed. Names match exactly.
+    void renameTag(const QString& from, const QString& to); // into `to` if it exists already
+    void mergeTags(const QStringList& from, const QString& into);
+    void deleteTag(const QString& name);
+
+    // All tag names with usage counts, for completion. Loaded once the store is
+    // open; thread-safe.
+    TagDictionary* tagDictionary() { return &m_tagDictionary; }
+    void reloadTagDictionary(); // after changes too broad to count one by one
+
+    // Sidecar imports (see SidecarImporter)
+    struct SidecarTags {
+        QString sidecar;                 // <folder>/.ts/<name>.json
+        qint64 mtime = 0;                // of the sidecar, seconds
+        QString path;                    // <folder>/<name>
+        std::optional<QStringList> tags; // none: the sidecar did not parse
+    };
+    // Sidecar path -> mtime when last imported, for sidecars under dirPath
+    QHash<QString, qint64> loadSidecarImportsUnder(const QString& dirPath);
+    // Records each sidecar as imported and sets its file's tags, unless they were
+    // edited after the sidecar was written. One write, one transaction; once it is
+    // committed, emits tagsChanged() with the stored tags of each file it tried to
+    // set. Returns how many it tried.
+    int importSidecarTags(const QVector<SidecarTags>& sidecars);
+
+    // File identities (see FileIdentity)
+    struct ScannedFile {
+        QString path;
+        qint64 size = 0;
+        qint64 mtime = 0; // seconds
+    };
+    // Records the identities of a scan of the files directly in dirPath. A file
+    // whose identity, size and mtime were last seen at another path that no longer
+    // exists was moved here: its path-keyed rows (tags, hash cache, placeholder,
+    // open tab) follow it, one index lookup each, no rehash. Only files new at
+    // their path or changed are stat()ed for their identity. Returns how many
+    // moved. Call before reading the folder's tags.
+    // Folders have no identity of their own: after a folder is renamed, its files
+    // are followed one by one as each of them is listed again, and files in
+    // folders never opened since stay behind until then.
+    int reattachMoved(const QString& dirPath, const QVector<ScannedFile>& files);
+
+signals:
+    void opened(bool ok);
+
+    // Once upsertTagsByPath() or a sidecar import is committed (not if it failed):
+    // lets loaded views follow edits without a rescan. seq: what upsertTagsByPath()
+    // returned, so an editor can tell its own saves from an equal change made
+    // elsewhere; 0 for an import. From the writer thread.
+    void tagsChanged(const QString& path, const QStringList& tags, quint64 seq);
+    // Once renameTag() and co are committed: every `from` is now `to`; `to` empty:
+    // deleted. From the writer thread.
+    void tagRenamed(const QString& from, const QString& to);
+
 private:
-    static QString tagsToJson(const QStringList& tags);
-    static QStringList jsonToTags(const QString& json);
+    static bool createSchema(QSqlDatabase& db); // on the writer thread
+
+    // Tag lists are owned by a path or a content hash (file_tags.kind)
+    std::optional<QStringList> getTags(int kind, const QString& key);
+    void upsertTags(int kind, const QString& key, const QStringList& tags);
+    // tags: normalizeTags()d
+    static void tagSteps(int kind, const QString& key, const QStringList& tags,
+                         QVector<StoreWriter::Step>* steps, QStringList* keys);
+    static QString tagsKey(int kind, const QString& key); // for read-your-writes
+    // Stored tags of those paths that have a record, one query per 500 (reader thread)
+    QHash<QString, QStringList> loadPathTags(const QStringList& paths);
+    void retag(const QStringList& from, const QString& to); // see renameTag()
+    static void moveSteps(const QString& from, const QString& to, QVector<StoreWriter::Step>* steps);
+
+    void startRead(std::function<void()> job);
+
+    // Background GC: one batch of one table per tick, cursor kept across ticks
+    void sweepStep();  // GUI thread (timer)
+    void sweepBatch(); // reader pool
+    // Looks for the missing files under a workspace root in all of its folders but
+    // hidden ones, reattaching those found; how many were (reader pool)
+    int scanWorkspace(const QString& root);
+    struct SweepState {
+        int table = 0;           // being walked
+        QString after;           // last key checked in it
+        qint64 checked = 0;      // this cycle
+        QVector<int> pruned;     // per table, this cycle
+        int tombstoned = 0;      // this cycle
+        QDeadlineTimer restUntil; // between cycles
+    };
+
+    // This thread's read-only connection, after open finished and the writes
+    // touching key (if any) are committed; null if the database is unusable.
+    StoreConnection* reader(const QString& key = {});
 
-    QSqlDatabase m_db;
+    QString m_dbPath;
+    StoreWriter m_writer;                           // all writes
+    QThreadStorage<StoreConnection*> m_readers;     // per thread, closed at thread exit
+    QThreadPool m_readPool;                         // read() jobs
+    TagDictionary m_tagDictionary;
+    QTimer m_sweepTimer;
+    std::atomic<bool> m_sweeping{false};            // a sweepBatch() is queued or running
+    std::atomic<quint64> m_editSeq{0};              // last upsertTagsByPath() sequence number
+    SweepState m_sweep;                             // touched by that sweepBatch() only
 };
 
 #endif // TAGGERSTORE_H
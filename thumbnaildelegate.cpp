@@ -1,7 +1,9 @@
 #include "thumbnaildelegate.h"
 
 #include "thumbnailmodel.h"
+#include "blurhash.h"
 #include <QPainter>
+#include <QPainterPath>
 #include <QAbstractItemView>
 
 ThumbnailDelegate::ThumbnailDelegate(QAbstractItemView* view)
@@ -15,6 +17,8 @@ ThumbnailDelegate::ThumbnailDelegate(QAbstractItemView* view)
             m_view->viewport()->update();
     });
     m_timer->start();
+
+    m_placeholders.setMaxCost(512); // decoded 32x32, ~4 KiB each
 }
 
 
@@ -46,7 +50,12 @@ void ThumbnailDelegate::paint(QPainter* p, const QStyleOptionViewItem& opt,
         iconSize, iconSize
         );
 
-    icon.paint(p, centeredIcon);
+    // Until the thumbnail lands, show its stored colour/BlurHash instead of the generic file icon
+    const int st = idx.data(ThumbnailModel::ThumbStatusRole).toInt();
+    const bool waiting = st == int(ThumbStatus::Loading) || st == int(ThumbStatus::NotRequested);
+    if (!waiting || !paintPlaceholder(p, centeredIcon, idx)) {
+        icon.paint(p, centeredIcon);
+    }
 
     QRect textRect = r;
     textRect.setTop(iconRect.bottom() + 6);
@@ -61,7 +70,6 @@ void ThumbnailDelegate::paint(QPainter* p, const QStyleOptionViewItem& opt,
     const QString elided = QFontMetrics(f).elidedText(name, Qt::ElideRight, textRect.width());
     p->drawText(textRect, Qt::AlignTop | Qt::AlignHCenter, elided);
 
-    const int st = idx.data(ThumbnailModel::ThumbStatusRole).toInt();
     if (st == int(ThumbStatus::Loading)) {
         paintBusy(p, opt.rect.adjusted(0,0,0,0));
     }
@@ -70,6 +78,35 @@ void ThumbnailDelegate::paint(QPainter* p, const QStyleOptionViewItem& opt,
     p->restore();
 }
 
+bool ThumbnailDelegate::paintPlaceholder(QPainter* p, const QRect& r, const QModelIndex& idx) const {
+    const QString hash = idx.data(ThumbnailModel::BlurHashRole).toString();
+    const QColor color = qvariant_cast<QColor>(idx.data(ThumbnailModel::PlaceholderColorRole));
+    if (hash.isEmpty() && !color.isValid()) return false;
+
+    p->save();
+    p->setRenderHint(QPainter::Antialiasing, true);
+    p->setRenderHint(QPainter::SmoothPixmapTransform, true);
+
+    QPainterPath clip;
+    clip.addRoundedRect(r, 6, 6);
+    p->setClipPath(clip);
+
+    QPixmap* decoded = hash.isEmpty() ? nullptr : m_placeholders.object(hash);
+    if (!decoded && !hash.isEmpty()) {
+        const QImage img = BlurHash::decode(hash, 32, 32);
+        if (!img.isNull()) {
+            decoded = new QPixmap(QPixmap::fromImage(img));
+            m_placeholders.insert(hash, decoded, 1);
+        }
+    }
+
+    if (decoded) p->drawPixmap(r, *decoded);
+    else p->fillRect(r, color);
+
+    p->restore();
+    return true;
+}
+
 void ThumbnailDelegate::paintBusy(QPainter* p, const QRect& rect) const {
     // draw in the top-right corner of the tile
     QRect r = rect.adjusted(rect.width() - 34, 10, -10, -rect.height() + 34);
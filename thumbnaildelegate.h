@@ -5,6 +5,8 @@
 #pragma once
 #include <QStyledItemDelegate>
 #include <QTimer>
+#include <QCache>
+#include <QPixmap>
 
 class ThumbnailDelegate : public QStyledItemDelegate {
     Q_OBJECT
@@ -21,10 +23,12 @@ private:
     QSize m_tile = QSize(140, 160);
 
     void paintBusy(QPainter* p, const QRect& r) const;
+    bool paintPlaceholder(QPainter* p, const QRect& r, const QModelIndex& idx) const;
 
     QAbstractItemView* m_view = nullptr;
     mutable int m_frame = 0;
     QTimer* m_timer = nullptr;
+    mutable QCache<QString, QPixmap> m_placeholders; // decoded BlurHash by hash string
 };
 
 
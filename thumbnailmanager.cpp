@@ -7,6 +7,7 @@
 #include <QPointer>
 #include <QStandardPaths>
 #include <QProcess>
+#include "blurhash.h"
 
 
 ThumbnailManager::ThumbnailManager(QObject* parent) : QObject(parent) {
@@ -79,7 +80,7 @@ bool ThumbnailManager::generateVideoThumbWithFfmpeg(const QString& videoPath, co
 }
 
 
-QPixmap ThumbnailManager::loadScaledMax400(const QString& path) {
+QImage ThumbnailManager::loadScaledMax400(const QString& path) {
     QImageReader reader(path);
     reader.setAutoTransform(true);
 
@@ -94,10 +95,15 @@ QPixmap ThumbnailManager::loadScaledMax400(const QString& path) {
         reader.setScaledSize(target);
     }
     // If smaller than 400x400, do not upscale: keep original
-    QImage img = reader.read();
-    if (img.isNull()) return {};
+    return reader.read();
+}
 
-    return QPixmap::fromImage(img);
+ThumbPlaceholder ThumbnailManager::makePlaceholder(const QImage& img) {
+    ThumbPlaceholder ph;
+    if (img.isNull()) return ph;
+    ph.color = BlurHash::dominantColor(img);
+    ph.blurHash = BlurHash::encode(img);
+    return ph;
 }
 
 bool ThumbnailManager::saveJpg(const QImage& img, const QString& outPath, int quality) {
@@ -107,7 +113,14 @@ bool ThumbnailManager::saveJpg(const QImage& img, const QString& outPath, int qu
     return writer.write(img);
 }
 
-void ThumbnailManager::request(const QString& absPath, const QString& tsThumbPath, int token) {
+void ThumbnailManager::cancelPending() {
+    QMutexLocker lock(&m_busyLock);
+    m_pool.clear();
+    m_queued.clear();
+}
+
+void ThumbnailManager::request(const QString& absPath, const QString& tsThumbPath, int token,
+                               bool wantPlaceholder, int priority) {
     if (absPath.isEmpty()) return;
 
     // Cache hit: deliver immediately
@@ -116,30 +129,57 @@ void ThumbnailManager::request(const QString& absPath, const QString& tsThumbPat
         return;
     }
 
+    {
+        QMutexLocker lock(&m_busyLock);
+        if (m_queued.contains(absPath) || m_running.contains(absPath)) return;
+        m_queued.insert(absPath);
+    }
+
     // Run async job
     struct Job : public QRunnable {
         QPointer<ThumbnailManager> mgr;
         QString absPath;
         QString tsThumbPath;
         int token;
+        bool wantPlaceholder;
 
-        Job(QPointer<ThumbnailManager> manager, const QString &absolutePath, const QString &tsPath, int tok) {
+        Job(QPointer<ThumbnailManager> manager, const QString &absolutePath, const QString &tsPath, int tok, bool placeholder) {
             mgr = manager;
             absPath = absolutePath;
             tsThumbPath = tsPath;
             token = tok;
+            wantPlaceholder = placeholder;
         }
 
         void run() override {
             if (!mgr) return;
+
+            // Queued -> running for the duration of this call
+            struct Busy {
+                ThumbnailManager* m;
+                QString path;
+                Busy(ThumbnailManager* mgr, const QString& p) : m(mgr), path(p) {
+                    QMutexLocker lock(&m->m_busyLock);
+                    m->m_queued.remove(path);
+                    m->m_running.insert(path);
+                }
+                ~Busy() {
+                    QMutexLocker lock(&m->m_busyLock);
+                    m->m_running.remove(path);
+                }
+            } busy(mgr.data(), absPath);
+
             // 1) If .ts thumb exists, load it
             if (QFileInfo::exists(tsThumbPath)) {
-                const QPixmap pm = ThumbnailManager::loadScaledMax400(tsThumbPath);
+                const QImage img = ThumbnailManager::loadScaledMax400(tsThumbPath);
+                const QPixmap pm = QPixmap::fromImage(img);
                 if (!pm.isNull()) {
+                    const ThumbPlaceholder ph = wantPlaceholder ? ThumbnailManager::makePlaceholder(img) : ThumbPlaceholder();
                     // store in cache on GUI thread via queued invoke
                     QPointer<ThumbnailManager> m = mgr;
-                    QMetaObject::invokeMethod(m, [m, absPath = absPath, token = token, pm]() {
+                    QMetaObject::invokeMethod(m, [m, absPath = absPath, token = token, pm, ph]() {
                         m->m_cache.insert(absPath, new QPixmap(pm), pixCost(pm));
+                        if (!ph.isNull()) emit m->placeholderReady(absPath, ph, token);
                         emit m->ready(absPath, pm, token);
                     }, Qt::QueuedConnection);
                     return;
@@ -150,12 +190,15 @@ void ThumbnailManager::request(const QString& absPath, const QString& tsThumbPat
             if (ThumbnailManager::isVideoFileByExt(absPath) && !mgr->m_ffmpegPath.isEmpty()) {
                 const bool ok = mgr->generateVideoThumbWithFfmpeg(absPath, tsThumbPath);
                 if (ok) {
-                    const QPixmap pm = ThumbnailManager::loadScaledMax400(tsThumbPath);
+                    const QImage img = ThumbnailManager::loadScaledMax400(tsThumbPath);
+                    const QPixmap pm = QPixmap::fromImage(img);
                     if (!pm.isNull()) {
+                        const ThumbPlaceholder ph = wantPlaceholder ? ThumbnailManager::makePlaceholder(img) : ThumbPlaceholder();
                         QPointer<ThumbnailManager> m = mgr;
-                        QMetaObject::invokeMethod(m, [m, absPath = absPath, pm, token = token]() {
+                        QMetaObject::invokeMethod(m, [m, absPath = absPath, pm, ph, token = token]() {
                             if (!m) return;
                             m->m_cache.insert(absPath, new QPixmap(pm), pixCost(pm));
+                            if (!ph.isNull()) emit m->placeholderReady(absPath, ph, token);
                             emit m->ready(absPath, pm, token);
                         }, Qt::QueuedConnection);
                         return;
@@ -226,18 +269,22 @@ void ThumbnailManager::request(const QString& absPath, const QString& tsThumbPat
             }
 
 
+            // Placeholder is cheap next to the decode above: both sample a 32x32 copy
+            const ThumbPlaceholder ph = wantPlaceholder ? ThumbnailManager::makePlaceholder(img) : ThumbPlaceholder();
+
             QPointer<ThumbnailManager> m = mgr;
-            QMetaObject::invokeMethod(m, [m, absPath = absPath, token = token, pm]() {
+            QMetaObject::invokeMethod(m, [m, absPath = absPath, token = token, pm, ph]() {
                 if (!m) return;
                 m->m_cache.insert(absPath, new QPixmap(pm), pixCost(pm));
+                if (!ph.isNull()) emit m->placeholderReady(absPath, ph, token);
                 emit m->ready(absPath, pm, token);
             }, Qt::QueuedConnection);
         }
     };
 
-    auto* job = new Job{QPointer<ThumbnailManager>(this), absPath, tsThumbPath, token};
+    auto* job = new Job{QPointer<ThumbnailManager>(this), absPath, tsThumbPath, token, wantPlaceholder};
     job->setAutoDelete(true);
-    m_pool.start(job);
+    m_pool.start(job, priority);
 }
 
 ThumbnailManager::~ThumbnailManager() {
@@ -4,8 +4,11 @@
 #pragma once
 #include <QObject>
 #include <QCache>
+#include <QMutex>
 #include <QPixmap>
+#include <QSet>
 #include <QThreadPool>
+#include "fileitem.h"
 
 class ThumbnailManager : public QObject {
     Q_OBJECT
@@ -13,18 +16,26 @@ public:
     explicit ThumbnailManager(QObject* parent = nullptr);
     ~ThumbnailManager() override;
 
-    void request(const QString& absPath, const QString& tsThumbPath, int token);
+    // wantPlaceholder: also compute a ThumbPlaceholder from the decoded image (see placeholderReady).
+    // Higher priority runs first; a path already queued or being decoded is not queued twice.
+    void request(const QString& absPath, const QString& tsThumbPath, int token,
+                 bool wantPlaceholder = false, int priority = 0);
+
+    // Drops every request not yet started (no signal for those); running ones still deliver.
+    void cancelPending();
     void setCacheLimit(int costLimit) { m_cache.setMaxCost(costLimit); }
 
 signals:
     void ready(const QString& absPath, const QPixmap& pix, int token);
     void unavailable(const QString& absPath, int token);
+    void placeholderReady(const QString& absPath, const ThumbPlaceholder& placeholder, int token);
 
 private:
     static bool isImageFile(const QString& absPath);
     static bool isVideoFileByExt(const QString& absPath);
 
-    static QPixmap loadScaledMax400(const QString& path);
+    static QImage loadScaledMax400(const QString& path);
+    static ThumbPlaceholder makePlaceholder(const QImage& img);
     static bool saveJpg(const QImage& img, const QString& outPath, int quality = 85);
 
     bool generateVideoThumbWithFfmpeg(const QString& videoPath, const QString& outJpg) const;
@@ -32,6 +43,10 @@ private:
     QThreadPool m_pool;
     QCache<QString, QPixmap> m_cache;
 
+    QMutex m_busyLock; // guards the two sets below, touched by jobs too
+    QSet<QString> m_queued;
+    QSet<QString> m_running;
+
     QString m_ffmpegPath;   // empty if not available
 };
 
@@ -1,5 +1,7 @@
 #include "thumbnailmodel.h"
 
+#include "sidecarimporter.h"
+
 // ThumbnailModel.cpp
 #include <QDirIterator>
 #include <QFileInfo>
@@ -7,41 +9,18 @@
 #include <algorithm>
 #include <QImageReader>
 #include <QDir>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
 #include <QFile>
+#include <QColor>
+#include <QRunnable>
+#include <QPointer>
+#include <memory>
+#include <numeric>
+#include <utility>
 
 #ifdef Q_OS_WIN
 #include <windows.h>
 #endif
 
-static QStringList loadTagsFromSidecar(const QString& jsonPath) {
-    QFile f(jsonPath);
-    if (!f.open(QIODevice::ReadOnly))
-        return {};
-
-    const auto doc = QJsonDocument::fromJson(f.readAll());
-    if (!doc.isObject())
-        return {};
-
-    const QJsonObject obj = doc.object();
-    const QJsonArray tagsArr = obj.value("tags").toArray();
-
-    QStringList result;
-    result.reserve(tagsArr.size());
-
-    for (const QJsonValue& v : tagsArr) {
-        const QJsonObject to = v.toObject();
-        const QString title = to.value("title").toString().trimmed();
-        if (!title.isEmpty())
-            result << title;
-    }
-
-    return result;
-}
-
-
 static QDateTime bestEffortCreatedTime(const QFileInfo& fi) {
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
     // Qt6: QFileInfo::birthTime() exists on many platforms but can be invalid
@@ -55,9 +34,12 @@ static QDateTime bestEffortCreatedTime(const QFileInfo& fi) {
 }
 
 ThumbnailModel::ThumbnailModel(QObject* parent) : QAbstractListModel(parent) {
+    m_indexPool.setMaxThreadCount(1);
+    m_loadPool.setMaxThreadCount(1);
+
     m_thumbs = new ThumbnailManager(this);
-    // optional: set cache limit
-    // m_thumbs->setCacheLimit(512 * 1024);
+    // Decoded pixmaps evicted from rows stay here a while, so scrolling back is cheap
+    m_thumbs->setCacheLimit(64 * 1024 * 1024);
 
     connect(m_thumbs, &ThumbnailManager::ready, this,
             [this](const QString& absPath, const QPixmap& pix, int token) {
@@ -69,11 +51,31 @@ ThumbnailModel::ThumbnailModel(QObject* parent) : QAbstractListModel(parent) {
 
                 m_items[row].thumbIcon = QIcon(pix);
                 m_items[row].thumbStatus = ThumbStatus::Ready;
+                m_requested.remove(row);
+                m_resident.insert(row);
 
                 const QModelIndex idx = index(row, 0);
                 emit dataChanged(idx, idx, {Qt::DecorationRole, IconRole, ThumbStatusRole});
             });
 
+    connect(m_thumbs, &ThumbnailManager::placeholderReady, this,
+            [this](const QString& absPath, const ThumbPlaceholder& ph, int token) {
+                if (token != m_token) return;
+                auto it = m_rowByPath.find(absPath);
+                if (it == m_rowByPath.end()) return;
+                const int row = it.value();
+                if (row < 0 || row >= m_items.size()) return;
+
+                FileItem& item = m_items[row];
+                item.placeholder = ph;
+                if (m_store) {
+                    m_store->upsertPlaceholder(absPath, item.sizeBytes, item.modified.toSecsSinceEpoch(), ph);
+                }
+
+                const QModelIndex idx = index(row, 0);
+                emit dataChanged(idx, idx, {PlaceholderColorRole, BlurHashRole});
+            });
+
     connect(m_thumbs, &ThumbnailManager::unavailable, this,
             [this](const QString& absPath, int token) {
                 if (token != m_token) return;
@@ -83,12 +85,20 @@ ThumbnailModel::ThumbnailModel(QObject* parent) : QAbstractListModel(parent) {
                 if (row < 0 || row >= m_items.size()) return;
 
                 m_items[row].thumbStatus = ThumbStatus::Unavailable;
+                m_requested.remove(row);
 
                 const QModelIndex idx = index(row, 0);
                 emit dataChanged(idx, idx, {ThumbStatusRole});
             });
 }
 
+ThumbnailModel::~ThumbnailModel() {
+    m_loadPool.clear();
+    m_loadPool.waitForDone();
+    m_indexPool.clear();
+    m_indexPool.waitForDone();
+}
+
 int ThumbnailModel::rowCount(const QModelIndex& parent) const {
     if (parent.isValid()) return 0;
     return m_items.size();
@@ -117,6 +127,9 @@ QVariant ThumbnailModel::data(const QModelIndex& index, int role) const {
     case SizeRole: return it.sizeBytes;
     case TagsRole: return it.tags;
     case FileKindRole: return static_cast<int>(it.kind);
+    case PlaceholderColorRole:
+        return it.placeholder.color ? QVariant(QColor::fromRgb(it.placeholder.color)) : QVariant();
+    case BlurHashRole: return it.placeholder.blurHash;
     default: return {};
     }
 }
@@ -132,16 +145,64 @@ QHash<int, QByteArray> ThumbnailModel::roleNames() const {
         {TagsRole, "tags"},
         {IconRole, "icon"},
         {FileKindRole, "fileKind"},
+        {PlaceholderColorRole, "placeholderColor"},
+        {BlurHashRole, "blurHash"},
     };
 }
 
+void ThumbnailModel::setStore(TaggerStore* store) {
+    if (m_store == store) return;
+    if (m_store) disconnect(m_store, nullptr, this, nullptr);
+    m_store = store;
+    if (m_store) {
+        connect(m_store, &TaggerStore::tagsChanged, this, &ThumbnailModel::onTagsChanged);
+        connect(m_store, &TaggerStore::tagRenamed, this, &ThumbnailModel::onTagRenamed);
+    }
+}
+
+void ThumbnailModel::onTagsChanged(const QString& path, const QStringList& tags) {
+    const int row = m_rowByPath.value(path, -1);
+    if (row < 0 || row >= m_items.size()) return; // not in this folder
+    if (m_items[row].tags == tags) return;
+
+    // Index first: the filter re-checks the row from it when it sees TagsRole
+    m_items[row].tags = tags;
+    m_index.setTags(row, tags);
+
+    const QModelIndex idx = index(row, 0);
+    emit dataChanged(idx, idx, {TagsRole});
+}
+
+void ThumbnailModel::onTagRenamed(const QString& from, const QString& to) {
+    // Same edit as the store's, on the rows in memory: no reload. One index
+    // update and one signal however many rows carry the tag.
+    QHash<int, QStringList> changed;
+    int first = -1, last = -1;
+    for (int row = 0; row < m_items.size(); ++row) {
+        QStringList& tags = m_items[row].tags;
+        if (!tags.contains(from)) continue;
+        tags = TaggerStore::renamedTags(tags, from, to);
+        changed.insert(row, tags);
+        if (first < 0) first = row;
+        last = row;
+    }
+    if (changed.isEmpty()) return;
+
+    m_index.setTags(changed);
+    emit dataChanged(index(first, 0), index(last, 0), {TagsRole});
+}
+
 void ThumbnailModel::setDirectory(const QString& dirPath) {
     if (dirPath.isEmpty()) {
         beginResetModel();
         m_items.clear();
+        m_index.clear();
         m_rowByPath.clear();
+        m_requested.clear();
+        m_resident.clear();
         m_dir.clear();
         ++m_token;
+        m_thumbs->cancelPending();
         endResetModel();
         return;
     }
@@ -150,18 +211,20 @@ void ThumbnailModel::setDirectory(const QString& dirPath) {
 }
 
 
-void ThumbnailModel::loadDirectory(const QString& dirPath) {
-    beginResetModel();
-    m_items.clear();
-    m_rowByPath.clear();
-    m_dir = dirPath;
-    ++m_token;
+namespace {
 
-    QFileIconProvider iconProvider;
+// One folder's rows as listed by a load job, sorted, icons still missing
+struct Listing {
+    QVector<FileItem> items;
+    QVector<QFileInfo> infos; // row-aligned, for the icon provider
+};
+
+Listing listDirectory(const QString& dirPath, TaggerStore* store) {
     const QDir baseDir(dirPath);
-    const QString tsDirPath = baseDir.absoluteFilePath(".ts");
-    QDir tsDir(tsDirPath);
 
+    QVector<FileItem> items;
+    QVector<QFileInfo> infos;
+    QVector<TaggerStore::ScannedFile> scanned;
     QDirIterator it(dirPath,
                     QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot,
                     QDirIterator::NoIteratorFlags);
@@ -179,36 +242,49 @@ void ThumbnailModel::loadDirectory(const QString& dirPath) {
         item.created = bestEffortCreatedTime(fi);
         item.sizeBytes = item.kind == FileKind::Directory ? 0 : fi.size();
 
-        // Icon always
-        item.icon = iconProvider.icon(fi);
-
         // Thumbnails only for files (folders shouldn’t have “.ts thumbnails”)
         if (item.kind == FileKind::Directory) {
             item.thumbStatus = ThumbStatus::Unavailable; // no spinner
         } else {
-            item.thumbStatus = ThumbStatus::Loading;     // your async pipeline will resolve it
-
-            if (m_store) {
-                if (auto t = m_store->getTagsByPath(item.absolutePath)) {
-                    item.tags = *t;
-                } else {
-                    // sidecar tags and thumb requests (your existing logic) still apply for files only
-                    // Sidecar tags: .ts/<originalFileName>.json
-                    const QString sidecarPath = tsDir.absoluteFilePath(item.fileName + ".json");
-                    if (QFileInfo::exists(sidecarPath)) {
-                        item.tags = loadTagsFromSidecar(sidecarPath);
-                    }
-                }
+            item.thumbStatus = ThumbStatus::NotRequested; // requested once the view shows it
+            if (store) {
+                scanned.push_back({item.absolutePath, item.sizeBytes, item.modified.toSecsSinceEpoch()});
             }
         }
 
+        items.push_back(std::move(item));
+        infos.push_back(fi);
+    }
 
-
-
-        m_items.push_back(std::move(item));
+    if (store) {
+        // Files moved here since the last scan bring their tags along first
+        store->reattachMoved(baseDir.absolutePath(), scanned);
+
+        // Sidecar tags (.ts/<name>.json) new or changed since the last visit
+        SidecarImporter::importFolder(store, baseDir.absolutePath());
+
+        // One range query each for the whole folder instead of lookups per file
+        const QHash<QString, TaggerStore::StoredPlaceholder> placeholders =
+            store->loadPlaceholdersInFolder(baseDir.absolutePath());
+        const QHash<QString, QStringList> storedTags = store->loadTagsInFolder(baseDir.absolutePath());
+
+        for (FileItem& item : items) {
+            if (item.kind == FileKind::Directory) continue;
+            // Made from an older version of the file: left out, so a new one is made
+            const auto ph = placeholders.constFind(item.absolutePath);
+            if (ph != placeholders.constEnd() && ph->size == item.sizeBytes
+                && ph->mtime == item.modified.toSecsSinceEpoch()) {
+                item.placeholder = ph->placeholder;
+            }
+            item.tags = storedTags.value(item.absolutePath);
+        }
     }
 
-    std::sort(m_items.begin(), m_items.end(), [](const FileItem& a, const FileItem& b) {
+    QVector<int> order(items.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&items](int ia, int ib) {
+        const FileItem& a = items[ia];
+        const FileItem& b = items[ib];
         const bool aDir = a.kind == FileKind::Directory;
         const bool bDir = b.kind == FileKind::Directory;
         if (aDir != bDir) return aDir > bDir; // dirs first
@@ -218,23 +294,182 @@ void ThumbnailModel::loadDirectory(const QString& dirPath) {
         return a.fileName.localeAwareCompare(b.fileName) < 0;
     });
 
+    Listing out;
+    out.items.reserve(order.size());
+    out.infos.reserve(order.size());
+    for (int i : order) {
+        out.items.push_back(std::move(items[i]));
+        out.infos.push_back(infos[i]);
+    }
+    return out;
+}
 
-    for (int i = 0; i < m_items.size(); ++i)
-        m_rowByPath.insert(m_items[i].absolutePath, i);
+} // namespace
 
+void ThumbnailModel::loadDirectory(const QString& dirPath) {
+    // Empty right away; rows arrive once the listing job is done. Directory walks and
+    // store reads both block on the disk, so neither runs here.
+    beginResetModel();
+    m_items.clear();
+    m_index.clear();
+    m_rowByPath.clear();
+    m_requested.clear();
+    m_resident.clear();
+    m_dir = dirPath;
+    ++m_token;
+    m_thumbs->cancelPending(); // previous folder's queue
     endResetModel();
 
-    // Start async requests AFTER reset to avoid chaos
-    for (const auto& item : m_items) {
+    struct Job : public QRunnable {
+        QPointer<ThumbnailModel> model;
+        TaggerStore* store;
+        QString dir;
+        int token;
+
+        Job(QPointer<ThumbnailModel> m, TaggerStore* s, const QString& d, int tok)
+            : model(m), store(s), dir(d), token(tok) {}
+
+        void run() override {
+            if (!model) return;
+            auto listing = std::make_shared<Listing>(listDirectory(dir, store));
+            if (store) store->upsertCatalog(QDir(dir).absolutePath(), listing->items); // queued
+
+            QPointer<ThumbnailModel> m = model;
+            QMetaObject::invokeMethod(m, [m, listing, token = token]() {
+                if (!m || token != m->m_token) return; // another folder by now
+                m->applyListing(std::move(listing->items), listing->infos);
+            }, Qt::QueuedConnection);
+        }
+    };
+
+    m_loadPool.clear(); // a queued listing of the previous folder is pointless now
+    auto* job = new Job(QPointer<ThumbnailModel>(this), m_store, dirPath, m_token);
+    job->setAutoDelete(true);
+    m_loadPool.start(job);
+}
+
+void ThumbnailModel::showFiles(QVector<FileItem> items, const QVector<QFileInfo>& infos) {
+    beginResetModel();
+    m_items.clear();
+    m_index.clear();
+    m_rowByPath.clear();
+    m_requested.clear();
+    m_resident.clear();
+    m_dir.clear(); // no folder: setDirectory() reloads whatever it is given
+    ++m_token;     // drops a listing still on its way
+    m_thumbs->cancelPending();
+    endResetModel();
+
+    applyListing(std::move(items), infos);
+}
+
+void ThumbnailModel::applyListing(QVector<FileItem> items, const QVector<QFileInfo>& infos) {
+    // Icon always; QFileIconProvider is GUI-thread only
+    QFileIconProvider iconProvider;
+    for (int i = 0; i < items.size(); ++i) items[i].icon = iconProvider.icon(infos[i]);
+
+    beginResetModel();
+    m_items = std::move(items);
+    m_index.clear();
+    m_index.reserve(m_items.size());
+    for (int i = 0; i < m_items.size(); ++i) {
+        m_rowByPath.insert(m_items[i].absolutePath, i);
+        m_index.append(m_items[i]);
+    }
+    endResetModel();
+
+    startIndexBuild();
+}
+
+void ThumbnailModel::requestThumbnails(const QVector<int>& rows) {
+    m_thumbs->cancelPending();
+
+    QSet<int> wanted;
+    wanted.reserve(rows.size());
+    for (int row : rows)
+        if (row >= 0 && row < m_items.size()) wanted.insert(row);
+
+    // Dropped requests go back to NotRequested. No dataChanged: the delegate paints
+    // both states the same and these rows are off screen by now.
+    for (auto it = m_requested.begin(); it != m_requested.end(); ) {
+        if (wanted.contains(*it)) { ++it; continue; }
+        m_items[*it].thumbStatus = ThumbStatus::NotRequested;
+        it = m_requested.erase(it);
+    }
+
+    int priority = rows.size();
+    for (int row : rows) {
+        --priority;
+        if (row < 0 || row >= m_items.size()) continue;
+        FileItem& item = m_items[row];
         if (item.kind == FileKind::Directory) continue;
-        const QString tsThumbPath = tsDir.absoluteFilePath(item.fileName + ".jpg");
-        m_thumbs->request(item.absolutePath, tsThumbPath, m_token);
+        if (item.thumbStatus == ThumbStatus::Ready || item.thumbStatus == ThumbStatus::Unavailable) continue;
+
+        // Re-queue Loading rows too: cancelPending() above dropped them unless already running
+        item.thumbStatus = ThumbStatus::Loading;
+        m_requested.insert(row);
+        // <folder>/.ts/<name>.jpg; search results span folders, so per item
+        const QString tsThumbPath = QFileInfo(item.absolutePath).path() + "/.ts/" + item.fileName + ".jpg";
+        m_thumbs->request(item.absolutePath, tsThumbPath, m_token, item.placeholder.isNull(), priority);
     }
 
+    if (m_resident.size() > kResidentThumbs)
+        releaseThumbnails(wanted, rows.isEmpty() ? 0 : rows.first());
+}
+
+void ThumbnailModel::releaseThumbnails(const QSet<int>& keep, int center) {
+    QVector<int> candidates;
+    candidates.reserve(m_resident.size());
+    for (int row : std::as_const(m_resident))
+        if (!keep.contains(row)) candidates.push_back(row);
+
+    // Farthest first
+    std::sort(candidates.begin(), candidates.end(), [center](int a, int b) {
+        return qAbs(a - center) > qAbs(b - center);
+    });
+
+    for (int row : candidates) {
+        if (m_resident.size() <= kResidentThumbs) break;
+        m_resident.remove(row);
+        FileItem& item = m_items[row];
+        item.thumbIcon = QIcon();
+        item.thumbStatus = ThumbStatus::NotRequested;
+
+        const QModelIndex idx = index(row, 0);
+        emit dataChanged(idx, idx, {Qt::DecorationRole, IconRole, ThumbStatusRole});
+    }
 }
 
 
 
+void ThumbnailModel::startIndexBuild() {
+    // Filtering works without it (plain scans); the trigram index only makes it faster.
+    struct Job : public QRunnable {
+        QPointer<ThumbnailModel> model;
+        SearchIndex snapshot; // implicitly shared copy, safe to read here
+        int token;
+
+        Job(QPointer<ThumbnailModel> m, const SearchIndex& index, int tok)
+            : model(m), snapshot(index), token(tok) {}
+
+        void run() override {
+            if (!model) return;
+            auto trigrams = std::make_shared<const TrigramIndex>(TrigramIndex::build(snapshot));
+
+            QPointer<ThumbnailModel> m = model;
+            QMetaObject::invokeMethod(m, [m, trigrams, token = token]() {
+                if (!m || token != m->m_token) return; // another folder by now
+                m->m_index.setTrigrams(trigrams);
+            }, Qt::QueuedConnection);
+        }
+    };
+
+    m_indexPool.clear(); // a queued build for the previous folder is pointless now
+    auto* job = new Job(QPointer<ThumbnailModel>(this), m_index, m_token);
+    job->setAutoDelete(true);
+    m_indexPool.start(job);
+}
+
 const FileItem& ThumbnailModel::itemAt(int row) const {
     static FileItem dummy;
     if (row < 0 || row >= m_items.size()) return dummy;
@@ -4,10 +4,14 @@
 // ThumbnailModel.h
 #pragma once
 #include <QAbstractListModel>
+#include <QFileInfo>
+#include <QSet>
 #include <QVector>
+#include <QThreadPool>
 #include "fileitem.h"
 #include "thumbnailmanager.h"
 #include "taggerstore.h"
+#include "searchindex.h"
 
 class ThumbnailModel : public QAbstractListModel {
     Q_OBJECT
@@ -21,31 +25,60 @@ public:
         TagsRole,
         IconRole,
         ThumbStatusRole,
-        FileKindRole
+        FileKindRole,
+        PlaceholderColorRole,
+        BlurHashRole
     };
 
     explicit ThumbnailModel(QObject* parent = nullptr);
+    ~ThumbnailModel() override;
 
     int rowCount(const QModelIndex& parent = {}) const override;
     QVariant data(const QModelIndex& index, int role) const override;
     QHash<int, QByteArray> roleNames() const override;
 
+    // Resets to empty at once; the folder's rows follow in a second reset once a
+    // background job has listed it and read its tags and placeholders.
     void setDirectory(const QString& dirPath);
+    // Arbitrary files instead of a folder (global search results), row-aligned
+    // with their infos; same roles, thumbnails and tag following as a folder.
+    void showFiles(QVector<FileItem> items, const QVector<QFileInfo>& infos);
     const FileItem& itemAt(int row) const;
     const FileItem* neighborFile(const QString& currentPath, int direction) const;
 
-    void setStore(TaggerStore* store) { m_store = store; }
+    // Typed, row-aligned access for the filter (no QVariant round-trips)
+    const SearchIndex& searchIndex() const { return m_index; }
+
+    // Also follows the store's tag edits (TagsRole) for rows of the loaded folder
+    void setStore(TaggerStore* store);
+
+    // Thumbnails are decoded on demand only. `rows` lists what the view needs, most
+    // urgent first; queued requests for any other row are dropped, and once more
+    // than kResidentThumbs are decoded the ones farthest from rows.first() are released.
+    void requestThumbnails(const QVector<int>& rows);
+
+    static constexpr int kResidentThumbs = 384;
 
 private:
     void loadDirectory(const QString& dirPath);
+    void applyListing(QVector<FileItem> items, const QVector<QFileInfo>& infos);
 
-    void startThumbRequests();
+    void startIndexBuild();
+    void onTagsChanged(const QString& path, const QStringList& tags);
+    void onTagRenamed(const QString& from, const QString& to);
+    void releaseThumbnails(const QSet<int>& keep, int center);
 
     ThumbnailManager* m_thumbs = nullptr;
+    QThreadPool m_loadPool;  // background directory listings (walk + store reads)
+    QThreadPool m_indexPool; // background index builds (trigrams)
     QHash<QString, int> m_rowByPath;
     int m_token = 0; // increments each loadDirectory
 
+    QSet<int> m_requested; // rows with a request out (ThumbStatus::Loading)
+    QSet<int> m_resident;  // rows holding a decoded thumbIcon
+
     QVector<FileItem> m_items;
+    SearchIndex m_index;
     QString m_dir;
     TaggerStore* m_store = nullptr;
 };
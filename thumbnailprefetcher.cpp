@@ -0,0 +1,138 @@
+#include "thumbnailprefetcher.h"
+
+#include "filterproxy.h"
+#include "thumbnailmodel.h"
+
+#include <QAbstractItemView>
+#include <QEvent>
+#include <QScrollBar>
+#include <QVector>
+
+// Look-ahead covers this much scrolling at the current speed, within [1, kMaxAheadScreens] screens
+static const double kLookaheadSecs = 0.75;
+static const int kMaxAheadScreens = 6;
+
+// Above this many screens per second the view is flinging; wait for it to settle
+static const double kFlingScreensPerSec = 12.0;
+
+ThumbnailPrefetcher::ThumbnailPrefetcher(QAbstractItemView* view, FilterProxy* proxy,
+                                         ThumbnailModel* model, QObject* parent)
+    : QObject(parent), m_view(view), m_proxy(proxy), m_model(model)
+{
+    m_coalesce.setSingleShot(true);
+    m_coalesce.setInterval(16);
+    connect(&m_coalesce, &QTimer::timeout, this, &ThumbnailPrefetcher::update);
+
+    m_settle.setSingleShot(true);
+    m_settle.setInterval(120);
+    connect(&m_settle, &QTimer::timeout, this, [this] {
+        m_velocity = 0;
+        m_lastFirst = -1;
+        update();
+    });
+
+    connect(view->verticalScrollBar(), &QScrollBar::valueChanged, this, &ThumbnailPrefetcher::schedule);
+    view->viewport()->installEventFilter(this);
+
+    auto restart = [this] {
+        m_velocity = 0;
+        m_lastFirst = -1;
+        schedule();
+    };
+    connect(proxy, &QAbstractItemModel::modelReset, this, restart);
+    connect(proxy, &QAbstractItemModel::layoutChanged, this, restart);
+    connect(proxy, &QAbstractItemModel::rowsInserted, this, &ThumbnailPrefetcher::schedule);
+
+    m_clock.start();
+}
+
+bool ThumbnailPrefetcher::eventFilter(QObject* watched, QEvent* event) {
+    if (event->type() == QEvent::Resize || event->type() == QEvent::Show) schedule();
+    return QObject::eventFilter(watched, event);
+}
+
+void ThumbnailPrefetcher::schedule() {
+    if (!m_coalesce.isActive()) m_coalesce.start();
+}
+
+void ThumbnailPrefetcher::visibleRange(int* first, int* last) const {
+    *first = 0;
+    *last = -1;
+    const int n = m_proxy->rowCount();
+    if (n == 0) return;
+
+    const QRect vp = m_view->viewport()->rect();
+    auto rectOf = [this](int row) { return m_view->visualRect(m_proxy->index(row, 0)); };
+
+    // Rows are laid out in reading order, so both bounds are binary searches
+    int lo = 0, hi = n;
+    while (lo < hi) {
+        const int mid = (lo + hi) / 2;
+        if (rectOf(mid).bottom() < vp.top()) lo = mid + 1;
+        else hi = mid;
+    }
+    *first = lo;
+
+    hi = n;
+    while (lo < hi) {
+        const int mid = (lo + hi) / 2;
+        if (rectOf(mid).top() <= vp.bottom()) lo = mid + 1;
+        else hi = mid;
+    }
+    *last = lo - 1;
+}
+
+void ThumbnailPrefetcher::update() {
+    if (!m_view || !m_proxy || !m_model) return;
+
+    int first, last;
+    visibleRange(&first, &last);
+    if (first > last) {
+        m_model->requestThumbnails({});
+        return;
+    }
+    const int visible = last - first + 1;
+
+    const qint64 ms = m_clock.restart();
+    if (m_lastFirst >= 0 && ms > 0 && ms < 500) {
+        const double v = (first - m_lastFirst) * 1000.0 / ms;
+        m_velocity = 0.6 * m_velocity + 0.4 * v;
+    } else {
+        m_velocity = 0;
+    }
+    m_lastFirst = first;
+
+    if (qAbs(m_velocity) > visible * kFlingScreensPerSec) {
+        m_settle.start();
+        return;
+    }
+    m_settle.stop();
+
+    const int ahead = qBound(visible, int(qAbs(m_velocity) * kLookaheadSecs), visible * kMaxAheadScreens);
+    request(first, last, ahead, visible / 2, m_velocity < 0 ? -1 : 1);
+}
+
+void ThumbnailPrefetcher::request(int first, int last, int ahead, int behind, int direction) {
+    // Scroll mode: materialize the rows we are about to need before the view hits the end
+    const int wantUpTo = direction > 0 ? last + ahead : last + behind;
+    if (wantUpTo >= m_proxy->rowCount() && m_proxy->canFetchMore({})) m_proxy->fetchMore({});
+
+    const int n = m_proxy->rowCount();
+    QVector<int> rows;
+    rows.reserve(last - first + 1 + ahead + behind);
+    auto add = [&](int proxyRow) {
+        if (proxyRow < 0 || proxyRow >= n) return;
+        const QModelIndex src = m_proxy->mapToSource(m_proxy->index(proxyRow, 0));
+        if (src.isValid()) rows.push_back(src.row());
+    };
+
+    for (int r = first; r <= last; ++r) add(r);
+    if (direction > 0) {
+        for (int r = last + 1; r <= last + ahead; ++r) add(r);
+        for (int r = first - 1; r >= first - behind; --r) add(r);
+    } else {
+        for (int r = first - 1; r >= first - ahead; --r) add(r);
+        for (int r = last + 1; r <= last + behind; ++r) add(r);
+    }
+    m_model->requestThumbnails(rows);
+}
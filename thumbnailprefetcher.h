@@ -0,0 +1,48 @@
+#ifndef THUMBNAILPREFETCHER_H
+#define THUMBNAILPREFETCHER_H
+
+#pragma once
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+class QAbstractItemView;
+class FilterProxy;
+class ThumbnailModel;
+
+// Drives ThumbnailModel::requestThumbnails() from what a view actually shows:
+// visible rows first, then rows ahead in the scroll direction (further ahead the
+// faster the user scrolls), then a little behind. During a fling nothing is
+// queued until the scroll settles, so the decoders never work for rows that are
+// already gone. Works in paged and scroll mode alike.
+class ThumbnailPrefetcher : public QObject {
+    Q_OBJECT
+public:
+    ThumbnailPrefetcher(QAbstractItemView* view, FilterProxy* proxy, ThumbnailModel* model,
+                        QObject* parent = nullptr);
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
+private:
+    void schedule();
+    void update();
+    void request(int first, int last, int ahead, int behind, int direction);
+
+    // Proxy rows [first, last] intersecting the viewport; first > last if none
+    void visibleRange(int* first, int* last) const;
+
+    QPointer<QAbstractItemView> m_view;
+    QPointer<FilterProxy> m_proxy;
+    QPointer<ThumbnailModel> m_model;
+
+    QTimer m_coalesce; // one update per burst of scroll events
+    QTimer m_settle;   // fired once a fling stops
+    QElapsedTimer m_clock;
+
+    int m_lastFirst = -1;
+    double m_velocity = 0; // rows per second, smoothed; negative = upwards
+};
+
+#endif // THUMBNAILPREFETCHER_H
@@ -0,0 +1,38 @@
+#include "trigramindex.h"
+
+#include "searchindex.h"
+
+#include <QVarLengthArray>
+#include <algorithm>
+
+TrigramIndex TrigramIndex::build(const SearchIndex& index) {
+    TrigramIndex out;
+    out.m_rows = index.rowCount();
+    for (int row = 0; row < out.m_rows; ++row) {
+        const QStringView name = index.foldedName(row);
+        for (int i = 0; i + kMinNeedle <= name.size(); ++i) {
+            // Rows are visited in order, so add() is an append (repeats are no-ops)
+            out.m_postings[key(name.data() + i)].add(row);
+        }
+    }
+    return out;
+}
+
+RowBitmap TrigramIndex::candidates(QStringView foldedNeedle) const {
+    if (foldedNeedle.size() < kMinNeedle) return RowBitmap::range(0, m_rows);
+
+    // Intersect rarest first: the running set shrinks fastest that way
+    QVarLengthArray<const RowBitmap*, 32> lists;
+    for (int i = 0; i + kMinNeedle <= foldedNeedle.size(); ++i) {
+        auto it = m_postings.constFind(key(foldedNeedle.data() + i));
+        if (it == m_postings.constEnd()) return {};
+        if (!std::count(lists.cbegin(), lists.cend(), &it.value())) lists.append(&it.value());
+    }
+    std::sort(lists.begin(), lists.end(), [](const RowBitmap* a, const RowBitmap* b) {
+        return a->cardinality() < b->cardinality();
+    });
+
+    RowBitmap out = *lists[0];
+    for (int i = 1; i < lists.size() && !out.isEmpty(); ++i) out &= *lists[i];
+    return out;
+}
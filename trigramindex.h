@@ -0,0 +1,34 @@
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+
+#pragma once
+#include <QHash>
+#include <QStringView>
+#include "rowbitmap.h"
+
+class SearchIndex;
+
+// Rows by every 3-code-unit substring of their case-folded file name.
+// Immutable once built; built off the GUI thread from a SearchIndex snapshot.
+class TrigramIndex {
+public:
+    static constexpr int kMinNeedle = 3;
+
+    static TrigramIndex build(const SearchIndex& index);
+
+    // Superset of the rows whose name contains the (folded) needle.
+    // Only meaningful for needles of at least kMinNeedle code units.
+    RowBitmap candidates(QStringView foldedNeedle) const;
+
+    int rowCount() const { return m_rows; }
+
+private:
+    static quint64 key(const QChar* p) {
+        return (quint64(p[0].unicode()) << 32) | (quint64(p[1].unicode()) << 16) | p[2].unicode();
+    }
+
+    QHash<quint64, RowBitmap> m_postings;
+    int m_rows = 0;
+};
+
+#endif // TRIGRAMINDEX_H
@@ -1,6 +1,7 @@
 #include "videodetailstab.h"
 
 #include "mpvopenglwidget.h"
+#include "tageditorbinding.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QToolButton>
@@ -304,47 +305,8 @@ QWidget* VideoDetailsTab::buildInfoPane(const FileItem& item) {
 
     layout->addWidget(new QLabel("Tags:", w));
     auto* tags = new QTextEdit(w);
-    tags->setText(item.tags.join(", "));
     layout->addWidget(tags, 1);
-
-    auto* saveTimer = new QTimer(this);
-    saveTimer->setSingleShot(true);
-    saveTimer->setInterval(300);
-
-    auto normalize = [](const QString& s) {
-        QStringList out;
-        for (auto part : s.split(',', Qt::SkipEmptyParts)) {
-            const QString t = part.trimmed();
-            if (!t.isEmpty()) out << t;
-        }
-        out.removeDuplicates();
-        return out;
-    };
-
-    connect(tags, &QTextEdit::textChanged, this, [saveTimer]{
-        saveTimer->start();
-    });
-
-    connect(saveTimer, &QTimer::timeout, this, [this, tags, normalize]{
-        if (!m_store) return;
-        m_currentTags = normalize(tags->toPlainText());
-
-        // 1) by path immediately
-        m_store->upsertTagsByPath(m_item.absolutePath, m_currentTags);
-
-        // 2) by hash when available
-        if (m_hasher) m_hasher->request(m_item.absolutePath);
-    });
-
-    if (m_hasher) {
-        connect(m_hasher, &FileHasher::hashReady, this,
-                [this](const QString& path, const QString& hash){
-                    if (!m_store) return;
-                    if (path != m_item.absolutePath) return;
-                    if (m_currentTags.isEmpty()) return;
-                    m_store->upsertTagsByHash(hash, m_currentTags);
-                });
-    }
+    new TagEditorBinding(tags, item, m_store, m_hasher);
 
     return w;
 }
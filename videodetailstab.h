@@ -33,7 +33,6 @@ private:
     TaggerStore* m_store = nullptr;
     FileHasher* m_hasher = nullptr;
     FileItem m_item;
-    QStringList m_currentTags;
 
 };
 